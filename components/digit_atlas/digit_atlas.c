@@ -0,0 +1,193 @@
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "digit_atlas.h"
+
+#define ATLAS_MAX_GLYPHS 32
+
+struct digit_atlas {
+    char charset[ATLAS_MAX_GLYPHS + 1];
+    uint8_t glyph_count;
+    int32_t cell_w, cell_h;
+    uint8_t *data;
+    uint32_t size;
+    lv_draw_buf_t tiles[ATLAS_MAX_GLYPHS];     // views into `data`
+};
+
+typedef struct {
+    const digit_atlas_t *atlas;
+    uint8_t cells;
+    char text[];                // one character per cell, '\0' blank
+} digit_label_t;
+
+// All tiles go through one canvas, stacked top to bottom, so each tile is
+// a contiguous image of its own
+static bool render_tiles(digit_atlas_t *atlas, const lv_font_t *font, lv_color_t color, lv_color_t bg,
+                         uint32_t stride)
+{
+    lv_draw_buf_t all;
+
+    if (lv_draw_buf_init(&all, atlas->cell_w, atlas->cell_h * atlas->glyph_count, LV_COLOR_FORMAT_RGB565,
+                         stride, atlas->data, atlas->size) != LV_RESULT_OK) {
+        return false;
+    }
+
+    // A screen that is never loaded, so nothing is invalidated
+    lv_obj_t *scratch = lv_obj_create(NULL);
+    lv_obj_t *canvas = lv_canvas_create(scratch);
+    lv_canvas_set_draw_buf(canvas, &all);
+    lv_canvas_fill_bg(canvas, bg, LV_OPA_COVER);
+
+    lv_layer_t layer;
+    lv_canvas_init_layer(canvas, &layer);
+
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.font = font;
+    dsc.color = color;
+    dsc.text_local = 1;
+
+    for (int i = 0; i < atlas->glyph_count; i++) {
+        const char text[2] = {atlas->charset[i], '\0'};
+        const int32_t w = lv_font_get_glyph_width(font, (uint32_t)(uint8_t)text[0], 0);
+        const lv_area_t area = {
+            .x1 = (atlas->cell_w - w) / 2,
+            .y1 = i * atlas->cell_h,
+            .x2 = atlas->cell_w - 1,
+            .y2 = (i + 1) * atlas->cell_h - 1,
+        };
+        dsc.text = text;
+        lv_draw_label(&layer, &dsc, &area);
+    }
+    lv_canvas_finish_layer(canvas, &layer);
+    lv_obj_delete(scratch);
+    return true;
+}
+
+digit_atlas_t *digit_atlas_create(const lv_font_t *font, const char *charset, lv_color_t color,
+                                  lv_color_t bg)
+{
+    const size_t count = strlen(charset);
+
+    if (count == 0 || count > ATLAS_MAX_GLYPHS) {
+        return NULL;
+    }
+
+    digit_atlas_t *atlas = heap_caps_calloc(1, sizeof(*atlas), MALLOC_CAP_8BIT);
+    if (atlas == NULL) {
+        return NULL;
+    }
+    memcpy(atlas->charset, charset, count);
+    atlas->glyph_count = (uint8_t)count;
+    atlas->cell_h = lv_font_get_line_height(font);
+    for (size_t i = 0; i < count; i++) {
+        const int32_t w = lv_font_get_glyph_width(font, (uint32_t)(uint8_t)charset[i], 0);
+        if (w > atlas->cell_w) {
+            atlas->cell_w = w;
+        }
+    }
+
+    const uint32_t stride = lv_draw_buf_width_to_stride(atlas->cell_w, LV_COLOR_FORMAT_RGB565);
+    const uint32_t tile_size = stride * atlas->cell_h;
+
+    atlas->size = tile_size * count;
+    atlas->data = heap_caps_malloc(atlas->size, MALLOC_CAP_8BIT);
+    if (atlas->data == NULL || !render_tiles(atlas, font, color, bg, stride)) {
+        heap_caps_free(atlas->data);
+        heap_caps_free(atlas);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        lv_draw_buf_init(&atlas->tiles[i], atlas->cell_w, atlas->cell_h, LV_COLOR_FORMAT_RGB565, stride,
+                         atlas->data + i * tile_size, tile_size);
+    }
+    return atlas;
+}
+
+uint32_t digit_atlas_get_size(const digit_atlas_t *atlas)
+{
+    return atlas->size;
+}
+
+static const lv_draw_buf_t *tile_for(const digit_atlas_t *atlas, char c)
+{
+    const char *p = c != '\0' && c != ' ' ? strchr(atlas->charset, c) : NULL;
+
+    return p != NULL ? &atlas->tiles[p - atlas->charset] : NULL;
+}
+
+static void cell_area(lv_obj_t *obj, const digit_atlas_t *atlas, int cell, lv_area_t *area)
+{
+    lv_obj_get_coords(obj, area);
+    area->x1 += cell * atlas->cell_w;
+    area->x2 = area->x1 + atlas->cell_w - 1;
+    area->y2 = area->y1 + atlas->cell_h - 1;
+}
+
+static void draw_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_current_target_obj(e);
+    const digit_label_t *dl = lv_obj_get_user_data(obj);
+    lv_layer_t *layer = lv_event_get_layer(e);
+    const lv_area_t *clip = &layer->_clip_area;
+
+    lv_draw_image_dsc_t image;
+    lv_draw_image_dsc_init(&image);
+
+    for (int i = 0; i < dl->cells; i++) {
+        const lv_draw_buf_t *tile = tile_for(dl->atlas, dl->text[i]);
+        lv_area_t cell;
+
+        cell_area(obj, dl->atlas, i, &cell);
+        if (tile == NULL || cell.x2 < clip->x1 || cell.x1 > clip->x2) {
+            continue;
+        }
+        image.src = tile;
+        lv_draw_image(layer, &image, &cell);
+    }
+}
+
+static void delete_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_current_target_obj(e);
+
+    lv_free(lv_obj_get_user_data(obj));
+    lv_obj_set_user_data(obj, NULL);
+}
+
+lv_obj_t *digit_label_create(lv_obj_t *parent, const digit_atlas_t *atlas, uint8_t cells)
+{
+    digit_label_t *dl = lv_malloc_zeroed(sizeof(*dl) + cells);
+
+    if (dl == NULL) {
+        return NULL;
+    }
+    dl->atlas = atlas;
+    dl->cells = cells;
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_size(obj, cells * atlas->cell_w, atlas->cell_h);
+    lv_obj_set_user_data(obj, dl);
+    lv_obj_add_event_cb(obj, draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, delete_cb, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+// Only cells whose character changed are redrawn
+void digit_label_set_text(lv_obj_t *obj, const char *text)
+{
+    digit_label_t *dl = lv_obj_get_user_data(obj);
+
+    for (int i = 0; i < dl->cells; i++) {
+        const char c = *text != '\0' ? *text++ : '\0';
+        if (c == dl->text[i]) {
+            continue;
+        }
+        dl->text[i] = c;
+
+        lv_area_t cell;
+        cell_area(obj, dl->atlas, i, &cell);
+        lv_obj_invalidate_area(obj, &cell);
+    }
+}
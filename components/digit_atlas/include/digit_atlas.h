@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+// Large readings drawn from pre-rendered glyph tiles.
+//
+// An atlas renders each character of a fixed set once, with LVGL's own
+// text rendering and so antialiased at the font's bpp, into an RGB565 tile
+// over an opaque background colour. A digit label is a row of cells of
+// the widest glyph's width. Setting its text invalidates only the cells
+// whose character changed, and a cell is drawn as one RGB565 image on the
+// RGB565 draw buffer, a copy row by row with no glyph rasterising. The
+// atlas grows with the font's size; whether the copy beats rasterising
+// is what `bench_digit_atlas` on the host measures.
+//
+// Meant for monospaced fonts; narrower glyphs are centred in their cell.
+// Characters outside the set, and spaces, leave their cell to the parent's
+// background, which should be the atlas background. Tiles come from the
+// system heap. Everything runs in the LVGL task.
+
+typedef struct digit_atlas digit_atlas_t;
+
+// Renders `charset` with `font` at boot, after the display exists. NULL
+// when out of memory.
+digit_atlas_t *digit_atlas_create(const lv_font_t *font, const char *charset, lv_color_t color,
+                                  lv_color_t bg);
+
+uint32_t digit_atlas_get_size(const digit_atlas_t *atlas);     // tile bytes
+
+// A label of `cells` characters; the atlas must outlive it
+lv_obj_t *digit_label_create(lv_obj_t *parent, const digit_atlas_t *atlas, uint8_t cells);
+
+// Longer text is cut to the label's cells
+void digit_label_set_text(lv_obj_t *obj, const char *text);
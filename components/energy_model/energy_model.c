@@ -0,0 +1,53 @@
+#include "energy_model.h"
+
+#define US_PER_HOUR 3600000000ULL
+
+static const char *const rail_names[ENERGY_RAIL_COUNT] = {
+    [ENERGY_CPU] = "cpu",
+    [ENERGY_SPI] = "spi",
+    [ENERGY_I2C] = "i2c",
+    [ENERGY_BACKLIGHT] = "backlight",
+    [ENERGY_SENSOR] = "sensor",
+};
+
+// uA * us -> nAh, without overflowing for runs of a few years
+static uint64_t charge_nah(uint32_t ua, uint64_t us)
+{
+    return (uint64_t)ua * (us / 1000) / (US_PER_HOUR / 1000000);
+}
+
+void energy_model_estimate(const energy_profile_t *profile, const energy_duty_t *duty, energy_report_t *report)
+{
+    const uint64_t elapsed = duty->elapsed_us;
+
+    report->elapsed_us = elapsed;
+    report->total_nah = 0;
+
+    for (int rail = 0; rail < ENERGY_RAIL_COUNT; rail++) {
+        uint64_t active = duty->active_us[rail];
+        if (active > elapsed) {
+            active = elapsed;
+        }
+
+        report->duty_permille[rail] = elapsed ? (uint32_t)(active * 1000 / elapsed) : 0;
+        report->charge_nah[rail] = charge_nah(profile->active_ua[rail], active) +
+                                   charge_nah(profile->idle_ua[rail], elapsed - active);
+        report->total_nah += report->charge_nah[rail];
+    }
+
+    // nAh over hours -> uA
+    report->avg_ua = elapsed ? (uint32_t)(report->total_nah * (US_PER_HOUR / 1000) / elapsed) : 0;
+}
+
+uint32_t energy_model_runtime_h(const energy_report_t *report, uint32_t capacity_mah)
+{
+    if (report->avg_ua == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)capacity_mah * 1000 / report->avg_ua);
+}
+
+const char *energy_rail_name(energy_rail_t rail)
+{
+    return rail < ENERGY_RAIL_COUNT ? rail_names[rail] : "?";
+}
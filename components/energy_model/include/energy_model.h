@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+
+// Battery charge estimate from duty cycles.
+//
+// Each rail draws `active_ua` while active and `idle_ua` for the rest of
+// the elapsed time; charge is the sum over rails. Duty cycles are measured
+// by the firmware (see power.h), currents come from datasheets and can be
+// replaced with bench measurements. Pure integer arithmetic and no
+// platform dependencies, so the host build runs it unchanged.
+
+typedef enum {
+    ENERGY_CPU,         // active: running at max frequency; idle: sleep/min frequency
+    ENERGY_SPI,         // active: display bus transferring
+    ENERGY_I2C,         // active: sensor bus transferring
+    ENERGY_BACKLIGHT,   // active: backlight on
+    ENERGY_SENSOR,      // active: standard periodic mode; idle: low-power periodic mode
+    ENERGY_RAIL_COUNT
+} energy_rail_t;
+
+typedef struct {
+    uint32_t active_ua[ENERGY_RAIL_COUNT];
+    uint32_t idle_ua[ENERGY_RAIL_COUNT];
+} energy_profile_t;
+
+// ESP32 at 160 MHz, ST7789 module with LED backlight, SCD41 at 3.3 V
+#define ENERGY_PROFILE_DEFAULT()                      \
+    {                                                 \
+        .active_ua = {                                \
+            [ENERGY_CPU] = 31000,                     \
+            [ENERGY_SPI] = 8000,                      \
+            [ENERGY_I2C] = 1000,                      \
+            [ENERGY_BACKLIGHT] = 20000,               \
+            [ENERGY_SENSOR] = 15000,                  \
+        },                                            \
+        .idle_ua = {                                  \
+            [ENERGY_CPU] = 20000,                     \
+            [ENERGY_SENSOR] = 3200,                   \
+        },                                            \
+    }
+
+typedef struct {
+    uint64_t elapsed_us;
+    uint64_t active_us[ENERGY_RAIL_COUNT];
+} energy_duty_t;
+
+typedef struct {
+    uint64_t elapsed_us;
+    uint32_t duty_permille[ENERGY_RAIL_COUNT];
+    uint64_t charge_nah[ENERGY_RAIL_COUNT];     // nano-amp-hours
+    uint64_t total_nah;
+    uint32_t avg_ua;
+} energy_report_t;
+
+void energy_model_estimate(const energy_profile_t *profile, const energy_duty_t *duty, energy_report_t *report);
+
+// Runtime in hours of a battery of `capacity_mah` at the report's average
+// current; 0 if nothing has been measured yet
+uint32_t energy_model_runtime_h(const energy_report_t *report, uint32_t capacity_mah);
+
+const char *energy_rail_name(energy_rail_t rail);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+// Interrupt-driven buttons with gesture recognition.
+//
+// Each button is an active-low GPIO with a level interrupt that is also a
+// light-sleep wakeup source. The interrupt disarms itself and starts a
+// one-shot debounce timer; when it expires the level is sampled and the
+// interrupt re-armed for the opposite level. Press and release feed a
+// per-button state machine on esp_timer that reports short, long and
+// double presses. Nothing runs while the buttons are idle: no task, no
+// polling.
+//
+// Handlers run in the esp_timer task and must not block.
+
+#define INPUT_MAX_BUTTONS 4
+#define INPUT_DEBOUNCE_MS 30
+#define INPUT_LONG_PRESS_MS 800
+
+typedef enum {
+    INPUT_SHORT_PRESS,
+    INPUT_LONG_PRESS,       // reported while still held
+    INPUT_DOUBLE_PRESS,
+    INPUT_GESTURE_COUNT
+} input_gesture_t;
+
+typedef struct {
+    uint8_t button;         // index into the configuration
+    uint8_t gesture;        // input_gesture_t
+    int64_t edge_us;        // interrupt time of the last edge before it was recognised
+} input_event_t;
+
+typedef void (*input_handler_t)(const input_event_t *event, void *ctx);
+
+typedef struct {
+    gpio_num_t gpio;
+    // Second press within this window is a double press. 0 disables double
+    // press detection, so a short press is reported on release rather than
+    // after the window.
+    uint16_t double_press_ms;
+} input_button_cfg_t;
+
+typedef struct {
+    uint32_t interrupts;
+    uint32_t bounces;           // debounce expired with the level unchanged
+    uint32_t gestures[INPUT_GESTURE_COUNT];
+    // Interrupt to "handled" as reported by input_note_handled()
+    uint32_t latency_count;
+    uint32_t latency_us_last;
+    uint32_t latency_us_max;
+    uint64_t latency_us_total;
+} input_stats_t;
+
+esp_err_t input_init(const input_button_cfg_t *buttons, uint32_t count, input_handler_t handler, void *ctx);
+
+// Record how long an event took to take visible effect, e.g. from the
+// interrupt to the end of the render that shows the new screen
+void input_note_handled(int64_t edge_us);
+
+void input_get_stats(input_stats_t *stats);
@@ -0,0 +1,209 @@
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "input.h"
+
+static const char *TAG = "INPUT";
+
+typedef enum {
+    BTN_IDLE,
+    BTN_PRESSED,
+    BTN_LONG_FIRED,     // held past the long press, waiting for release
+    BTN_WAIT_DOUBLE,    // released, a second press would be a double
+    BTN_PRESSED_SECOND,
+} button_state_t;
+
+typedef struct {
+    input_button_cfg_t cfg;
+    uint8_t index;
+    bool pressed;                   // debounced level
+    button_state_t state;
+    volatile int64_t edge_us;       // written by the ISR
+    esp_timer_handle_t debounce;
+    esp_timer_handle_t gesture;     // long press or double press window
+} button_t;
+
+static button_t buttons[INPUT_MAX_BUTTONS];
+static input_handler_t handler = NULL;
+static void *handler_ctx = NULL;
+static input_stats_t stats;
+
+static void IRAM_ATTR button_isr(void *arg)
+{
+    button_t *b = arg;
+
+    // Level interrupt: silence it until the debounce timer has looked
+    gpio_intr_disable(b->cfg.gpio);
+    b->edge_us = esp_timer_get_time();
+    stats.interrupts++;
+    esp_timer_start_once(b->debounce, INPUT_DEBOUNCE_MS * 1000);
+}
+
+// Wait for the opposite level; the same level also wakes from light sleep
+static void button_arm(button_t *b)
+{
+    gpio_wakeup_enable(b->cfg.gpio, b->pressed ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    gpio_intr_enable(b->cfg.gpio);
+}
+
+static void button_emit(button_t *b, input_gesture_t gesture)
+{
+    const input_event_t event = {
+        .button = b->index,
+        .gesture = gesture,
+        .edge_us = b->edge_us,
+    };
+
+    stats.gestures[gesture]++;
+    if (handler) {
+        handler(&event, handler_ctx);
+    }
+}
+
+static void gesture_restart(button_t *b, uint32_t ms)
+{
+    esp_timer_stop(b->gesture);
+    esp_timer_start_once(b->gesture, (uint64_t)ms * 1000);
+}
+
+static void button_pressed(button_t *b)
+{
+    switch (b->state) {
+        case BTN_IDLE:
+            b->state = BTN_PRESSED;
+            gesture_restart(b, INPUT_LONG_PRESS_MS);
+            break;
+        case BTN_WAIT_DOUBLE:
+            esp_timer_stop(b->gesture);
+            b->state = BTN_PRESSED_SECOND;
+            break;
+        default:
+            break;
+    }
+}
+
+static void button_released(button_t *b)
+{
+    switch (b->state) {
+        case BTN_PRESSED:
+            esp_timer_stop(b->gesture);
+            if (b->cfg.double_press_ms == 0) {
+                b->state = BTN_IDLE;
+                button_emit(b, INPUT_SHORT_PRESS);
+            } else {
+                b->state = BTN_WAIT_DOUBLE;
+                gesture_restart(b, b->cfg.double_press_ms);
+            }
+            break;
+        case BTN_PRESSED_SECOND:
+            b->state = BTN_IDLE;
+            button_emit(b, INPUT_DOUBLE_PRESS);
+            break;
+        case BTN_LONG_FIRED:
+            b->state = BTN_IDLE;
+            break;
+        default:
+            break;
+    }
+}
+
+static void debounce_cb(void *arg)
+{
+    button_t *b = arg;
+    const bool pressed = gpio_get_level(b->cfg.gpio) == 0;
+
+    if (pressed == b->pressed) {
+        stats.bounces++;
+        button_arm(b);
+        return;
+    }
+    b->pressed = pressed;
+    button_arm(b);
+
+    if (pressed) {
+        button_pressed(b);
+    } else {
+        button_released(b);
+    }
+}
+
+static void gesture_cb(void *arg)
+{
+    button_t *b = arg;
+
+    if (b->state == BTN_PRESSED) {
+        b->state = BTN_LONG_FIRED;
+        button_emit(b, INPUT_LONG_PRESS);
+    } else if (b->state == BTN_WAIT_DOUBLE) {
+        b->state = BTN_IDLE;
+        button_emit(b, INPUT_SHORT_PRESS);
+    }
+}
+
+esp_err_t input_init(const input_button_cfg_t *cfg, uint32_t count, input_handler_t on_event, void *ctx)
+{
+    if (!cfg || count == 0 || count > INPUT_MAX_BUTTONS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handler = on_event;
+    handler_ctx = ctx;
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        button_t *b = &buttons[i];
+        memset(b, 0, sizeof(*b));
+        b->cfg = cfg[i];
+        b->index = i;
+
+        const esp_timer_create_args_t debounce_args = {
+            .callback = debounce_cb,
+            .arg = b,
+            .name = "btn_debounce",
+        };
+        const esp_timer_create_args_t gesture_args = {
+            .callback = gesture_cb,
+            .arg = b,
+            .name = "btn_gesture",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&debounce_args, &b->debounce));
+        ESP_ERROR_CHECK(esp_timer_create(&gesture_args, &b->gesture));
+
+        gpio_config_t io_conf = {
+            .pin_bit_mask = 1ULL << b->cfg.gpio,
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = GPIO_PULLUP_ENABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_LOW_LEVEL,
+        };
+        ESP_ERROR_CHECK(gpio_config(&io_conf));
+        ESP_ERROR_CHECK(gpio_isr_handler_add(b->cfg.gpio, button_isr, b));
+        button_arm(b);
+        ESP_LOGI(TAG, "Button %u on GPIO %d", (unsigned)i, b->cfg.gpio);
+    }
+
+    return esp_sleep_enable_gpio_wakeup();
+}
+
+void input_note_handled(int64_t edge_us)
+{
+    const uint32_t us = (uint32_t)(esp_timer_get_time() - edge_us);
+
+    stats.latency_count++;
+    stats.latency_us_last = us;
+    stats.latency_us_total += us;
+    if (us > stats.latency_us_max) {
+        stats.latency_us_max = us;
+    }
+}
+
+void input_get_stats(input_stats_t *out)
+{
+    *out = stats;
+}
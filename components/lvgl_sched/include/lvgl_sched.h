@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "lvgl.h"
+
+// The one task that runs LVGL.
+//
+// LVGL reads time from esp_timer_get_time() through lv_tick_set_cb, so
+// there is no periodic tick interrupt. After each lv_timer_handler() pass
+// the task sleeps until the next LVGL timer is due; with nothing pending
+// (refresh timer paused, no animations) it sleeps until woken. Wakeups
+// come from lvgl_sched_wake(), e.g. when a command is queued for the UI,
+// and from lvgl_sched_unlock() when another task has changed widgets.
+// The counters are written by the LVGL task only.
+
+typedef struct {
+    int task_priority;
+    int task_stack;
+} lvgl_sched_cfg_t;
+
+#define LVGL_SCHED_DEFAULT_CONFIG() \
+    {                               \
+        .task_priority = 4,         \
+        .task_stack = 7168,         \
+    }
+
+typedef struct {
+    uint32_t wakeups;               // handler passes
+    uint32_t notified;              // wakeups caused by wake/unlock
+    uint32_t coalesced;             // wake requests merged into an earlier pending one
+    uint32_t render_passes;         // of attached displays
+    uint32_t wakeups_per_s_x10;     // over the last measuring window
+    uint32_t renders_per_s_x10;
+} lvgl_sched_stats_t;
+
+// Calls lv_init() and starts the task
+esp_err_t lvgl_sched_init(const lvgl_sched_cfg_t *cfg);
+
+// Count render passes of a display and time them into the "render"
+// perf histogram
+void lvgl_sched_attach_display(lv_display_t *disp);
+
+// Recursive. timeout_ms 0 waits forever.
+bool lvgl_sched_lock(uint32_t timeout_ms);
+void lvgl_sched_unlock(void);
+
+void lvgl_sched_wake(void);
+void lvgl_sched_wake_from_isr(BaseType_t *higher_prio_woken);
+
+// Called in LVGL context, lock held, before every lv_timer_handler() pass
+void lvgl_sched_set_pre_handler(void (*hook)(void));
+
+void lvgl_sched_get_stats(lvgl_sched_stats_t *stats);
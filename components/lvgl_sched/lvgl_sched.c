@@ -0,0 +1,159 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "perf.h"
+#include "lvgl_sched.h"
+
+static const char *TAG = "LVGL_SCHED";
+
+#define STATS_WINDOW_US 1000000
+
+static SemaphoreHandle_t lvgl_mux = NULL;
+static TaskHandle_t lvgl_task = NULL;
+static void (*pre_handler)(void) = NULL;
+
+static lvgl_sched_stats_t stats;
+static int64_t window_start_us;
+static uint32_t window_wakeups;
+static uint32_t window_renders;
+static perf_hist_t *render_hist = NULL;
+static uint32_t render_start_cycles;
+
+static uint32_t tick_get_cb(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void render_start_cb(lv_event_t *e)
+{
+    stats.render_passes++;
+    window_renders++;
+    render_start_cycles = perf_cycles();
+}
+
+// Drawing and handing areas to the flush callback, including any wait for
+// a free draw buffer
+static void render_ready_cb(lv_event_t *e)
+{
+    perf_hist_add(render_hist, perf_cycles_to_us(perf_cycles() - render_start_cycles));
+}
+
+static void stats_update(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - window_start_us;
+
+    stats.wakeups++;
+    window_wakeups++;
+    if (elapsed >= STATS_WINDOW_US) {
+        stats.wakeups_per_s_x10 = (uint32_t)((int64_t)window_wakeups * 10000000 / elapsed);
+        stats.renders_per_s_x10 = (uint32_t)((int64_t)window_renders * 10000000 / elapsed);
+        window_start_us = now;
+        window_wakeups = 0;
+        window_renders = 0;
+    }
+}
+
+static void lvgl_sched_task(void *arg)
+{
+    ESP_LOGI(TAG, "Starting LVGL task");
+    window_start_us = esp_timer_get_time();
+
+    while (1) {
+        uint32_t delay_ms = LV_NO_TIMER_READY;
+
+        if (lvgl_sched_lock(0)) {
+            stats_update();
+            if (pre_handler) {
+                pre_handler();
+            }
+            delay_ms = lv_timer_handler();
+            lvgl_sched_unlock();
+        }
+
+        // Round up so a short deadline is not a busy loop, and never sleep
+        // zero ticks
+        TickType_t ticks = portMAX_DELAY;
+        if (delay_ms != LV_NO_TIMER_READY) {
+            ticks = (delay_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+            if (ticks == 0) {
+                ticks = 1;
+            }
+        }
+        // Wake requests made while one was pending share its wakeup
+        const uint32_t requests = ulTaskNotifyTake(pdTRUE, ticks);
+        if (requests > 0) {
+            stats.notified++;
+            stats.coalesced += requests - 1;
+        }
+    }
+}
+
+esp_err_t lvgl_sched_init(const lvgl_sched_cfg_t *cfg)
+{
+    if (!cfg) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lv_init();
+    lv_tick_set_cb(tick_get_cb);
+
+    lvgl_mux = xSemaphoreCreateRecursiveMutex();
+    if (!lvgl_mux) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(lvgl_sched_task, "taskLVGL", cfg->task_stack, NULL, cfg->task_priority, &lvgl_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void lvgl_sched_attach_display(lv_display_t *disp)
+{
+    if (!render_hist) {
+        render_hist = perf_hist_register("render");
+    }
+    lv_display_add_event_cb(disp, render_start_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(disp, render_ready_cb, LV_EVENT_RENDER_READY, NULL);
+}
+
+bool lvgl_sched_lock(uint32_t timeout_ms)
+{
+    const TickType_t ticks = (timeout_ms == 0) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTakeRecursive(lvgl_mux, ticks) == pdTRUE;
+}
+
+void lvgl_sched_unlock(void)
+{
+    xSemaphoreGiveRecursive(lvgl_mux);
+    // Another task may have invalidated widgets; let LVGL look at them
+    if (xTaskGetCurrentTaskHandle() != lvgl_task) {
+        lvgl_sched_wake();
+    }
+}
+
+void lvgl_sched_wake(void)
+{
+    if (lvgl_task) {
+        xTaskNotifyGive(lvgl_task);
+    }
+}
+
+void lvgl_sched_wake_from_isr(BaseType_t *higher_prio_woken)
+{
+    if (lvgl_task) {
+        vTaskNotifyGiveFromISR(lvgl_task, higher_prio_woken);
+    }
+}
+
+void lvgl_sched_set_pre_handler(void (*hook)(void))
+{
+    pre_handler = hook;
+}
+
+void lvgl_sched_get_stats(lvgl_sched_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+
+// Runtime performance counters.
+//
+// Latency histograms have power-of-two microsecond buckets and can be fed
+// from any context, ISRs included. Each histogram has a single writer;
+// readers accept a snapshot that may be one sample out of step. Short
+// CPU-bound spans are timed with the cycle counter (perf_cycles()); spans
+// that wait on hardware use esp_timer instead, because the cycle counter
+// stops in light sleep.
+//
+// Producers register their histograms by name, so one report covers all
+// of them. Per-task CPU share and stack high-water marks come from the
+// FreeRTOS run time stats.
+
+#define PERF_HIST_BUCKETS   20      // [2^i, 2^(i+1)) us; the last one is open
+#define PERF_MAX_HISTS      8
+#define PERF_MAX_TASKS      16
+#define PERF_TASK_NAME_LEN  16
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[PERF_HIST_BUCKETS];
+} perf_hist_t;
+
+typedef struct {
+    TaskHandle_t handle;
+    char name[PERF_TASK_NAME_LEN];
+    configRUN_TIME_COUNTER_TYPE run_time;
+    uint16_t cpu_permille;          // of one core, since the previous sample
+    uint32_t stack_free;            // bytes, lowest ever
+} perf_task_t;
+
+// Owned by the caller, so independent readers each get their own window
+typedef struct {
+    int count;                      // sorted by CPU share, busiest first
+    configRUN_TIME_COUNTER_TYPE total;
+    perf_task_t tasks[PERF_MAX_TASKS];
+} perf_tasks_t;
+
+// Static storage for the whole run; NULL once PERF_MAX_HISTS are taken.
+// `name` must outlive the histogram.
+perf_hist_t *perf_hist_register(const char *name);
+
+// ISR-safe; ignores a NULL histogram so producers need no checks
+void perf_hist_add(perf_hist_t *hist, uint32_t us);
+
+// Upper bound of the bucket holding the given percentile, capped at the
+// maximum seen; 0 when empty
+uint32_t perf_hist_percentile(const perf_hist_t *hist, uint32_t pct);
+
+int perf_hist_count(void);
+const perf_hist_t *perf_hist_get(int index);
+
+static inline uint32_t perf_cycles(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+// At the current CPU frequency
+uint32_t perf_cycles_to_us(uint32_t cycles);
+
+// Refresh `tasks` and the CPU shares since it was last sampled. Empty
+// without CONFIG_FREERTOS_USE_TRACE_FACILITY, or with more than
+// PERF_MAX_TASKS tasks.
+void perf_tasks_sample(perf_tasks_t *tasks);
+
+// Compact one-line forms, shared by the console log, the diagnostics
+// screen and the host report
+int perf_format_hist(const perf_hist_t *hist, char *buf, size_t len);
+int perf_format_task(const perf_task_t *task, char *buf, size_t len);
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_rom_sys.h"
+#include "sdkconfig.h"
+#include "perf.h"
+
+static perf_hist_t hists[PERF_MAX_HISTS];
+static int hist_count = 0;
+static portMUX_TYPE hist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+perf_hist_t *perf_hist_register(const char *name)
+{
+    perf_hist_t *hist = NULL;
+
+    portENTER_CRITICAL(&hist_lock);
+    if (hist_count < PERF_MAX_HISTS) {
+        hist = &hists[hist_count];
+        hist->name = name;
+        hist_count++;
+    }
+    portEXIT_CRITICAL(&hist_lock);
+    return hist;
+}
+
+void IRAM_ATTR perf_hist_add(perf_hist_t *hist, uint32_t us)
+{
+    if (!hist) {
+        return;
+    }
+    int bucket = us < 2 ? 0 : 31 - __builtin_clz(us);
+    if (bucket >= PERF_HIST_BUCKETS) {
+        bucket = PERF_HIST_BUCKETS - 1;
+    }
+    hist->buckets[bucket]++;
+    hist->total_us += us;
+    hist->last_us = us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+    hist->count++;
+}
+
+uint32_t perf_hist_percentile(const perf_hist_t *hist, uint32_t pct)
+{
+    const uint64_t rank = ((uint64_t)hist->count * pct + 99) / 100;
+    uint64_t seen = 0;
+
+    if (hist->count == 0) {
+        return 0;
+    }
+    for (int i = 0; i < PERF_HIST_BUCKETS - 1; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            const uint32_t bound = 2u << i;
+            return bound < hist->max_us ? bound : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+int perf_hist_count(void)
+{
+    return hist_count;
+}
+
+const perf_hist_t *perf_hist_get(int index)
+{
+    return (index >= 0 && index < hist_count) ? &hists[index] : NULL;
+}
+
+uint32_t perf_cycles_to_us(uint32_t cycles)
+{
+    return cycles / esp_rom_get_cpu_ticks_per_us();
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+void perf_tasks_sample(perf_tasks_t *out)
+{
+    TaskStatus_t status[PERF_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    perf_tasks_t prev = *out;
+
+    const UBaseType_t n = uxTaskGetSystemState(status, PERF_MAX_TASKS, &total);
+    const configRUN_TIME_COUNTER_TYPE window = total - prev.total;
+
+    out->count = 0;
+    out->total = total;
+    for (UBaseType_t i = 0; i < n; i++) {
+        perf_task_t task = {
+            .handle = status[i].xHandle,
+            .run_time = status[i].ulRunTimeCounter,
+            .stack_free = status[i].usStackHighWaterMark,
+        };
+        snprintf(task.name, sizeof(task.name), "%s", status[i].pcTaskName);
+
+        // Tasks created since the last sample count from zero
+        configRUN_TIME_COUNTER_TYPE before = 0;
+        for (int j = 0; j < prev.count; j++) {
+            if (prev.tasks[j].handle == task.handle) {
+                before = prev.tasks[j].run_time;
+                break;
+            }
+        }
+        if (window > 0 && task.run_time >= before) {
+            task.cpu_permille = (uint16_t)((task.run_time - before) * 1000 / window);
+        }
+
+        // Insertion by CPU share
+        int pos = out->count++;
+        while (pos > 0 && out->tasks[pos - 1].cpu_permille < task.cpu_permille) {
+            out->tasks[pos] = out->tasks[pos - 1];
+            pos--;
+        }
+        out->tasks[pos] = task;
+    }
+}
+#else
+void perf_tasks_sample(perf_tasks_t *out)
+{
+    out->count = 0;
+}
+#endif
+
+int perf_format_hist(const perf_hist_t *hist, char *buf, size_t len)
+{
+    return snprintf(buf, len, "%s n=%u avg=%u p50=%u p95=%u max=%u us", hist->name, (unsigned)hist->count,
+                    hist->count ? (unsigned)(hist->total_us / hist->count) : 0,
+                    (unsigned)perf_hist_percentile(hist, 50), (unsigned)perf_hist_percentile(hist, 95),
+                    (unsigned)hist->max_us);
+}
+
+int perf_format_task(const perf_task_t *task, char *buf, size_t len)
+{
+    return snprintf(buf, len, "%s cpu=%u.%u%% stack_free=%u", task->name, task->cpu_permille / 10,
+                    task->cpu_permille % 10, (unsigned)task->stack_free);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "energy_model.h"
+
+// Power management and duty-cycle accounting.
+//
+// power_init() enables dynamic frequency scaling with automatic light
+// sleep when the build has CONFIG_PM_ENABLE: the CPU drops to
+// POWER_MIN_FREQ_MHZ and sleeps whenever every task is blocked, which with
+// the on-demand LVGL task is most of the time between sensor samples.
+//
+// Rails are accounted as time spent active. CPU time is derived from the
+// idle task's run time counter when the report is taken; bus owners add
+// their transfer time, and the backlight and sensor mode are tracked as
+// state changes.
+
+#define POWER_MAX_FREQ_MHZ 160
+#define POWER_MIN_FREQ_MHZ 40
+
+esp_err_t power_init(void);
+
+// True once light sleep has been enabled
+bool power_light_sleep_enabled(void);
+
+void power_add_active(energy_rail_t rail, uint32_t active_us);
+
+// State-tracked rails: active from now until switched off
+void power_set_backlight(bool on);
+void power_set_sensor_low_power(bool low_power);
+
+// Duty cycles since power_init()
+void power_get_duty(energy_duty_t *duty);
+
+// Duty cycles run through the model with the profile for this build
+void power_get_report(energy_report_t *report);
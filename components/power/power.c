@@ -0,0 +1,123 @@
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+#include "power.h"
+
+static const char *TAG = "POWER";
+
+// Light sleep averaged with the wakeup overhead at the 100 Hz tick
+#define CPU_IDLE_LIGHT_SLEEP_UA 1500
+
+static portMUX_TYPE power_lock = portMUX_INITIALIZER_UNLOCKED;
+static energy_profile_t profile = ENERGY_PROFILE_DEFAULT();
+static bool light_sleep = false;
+static int64_t start_us;
+static uint64_t start_idle;
+
+static uint64_t active_us[ENERGY_RAIL_COUNT];
+static int64_t active_since_us[ENERGY_RAIL_COUNT];     // 0 when off
+
+esp_err_t power_init(void)
+{
+    start_us = esp_timer_get_time();
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    start_idle = ulTaskGetIdleRunTimeCounter();
+#endif
+
+#if CONFIG_PM_ENABLE
+    const esp_pm_config_t pm_config = {
+        .max_freq_mhz = POWER_MAX_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_FREQ_MHZ,
+        .light_sleep_enable = true,
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Power management not configured (%s)", esp_err_to_name(err));
+        profile.idle_ua[ENERGY_CPU] = profile.active_ua[ENERGY_CPU];
+        return err;
+    }
+    light_sleep = true;
+    profile.idle_ua[ENERGY_CPU] = CPU_IDLE_LIGHT_SLEEP_UA;
+    ESP_LOGI(TAG, "DFS %d-%d MHz with automatic light sleep", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ);
+#else
+    // Without DFS the idle task spins at full frequency
+    profile.idle_ua[ENERGY_CPU] = profile.active_ua[ENERGY_CPU];
+    ESP_LOGI(TAG, "Power management disabled in this build");
+#endif
+    return ESP_OK;
+}
+
+bool power_light_sleep_enabled(void)
+{
+    return light_sleep;
+}
+
+void power_add_active(energy_rail_t rail, uint32_t us)
+{
+    if (rail >= ENERGY_RAIL_COUNT) {
+        return;
+    }
+    portENTER_CRITICAL(&power_lock);
+    active_us[rail] += us;
+    portEXIT_CRITICAL(&power_lock);
+}
+
+static void rail_set(energy_rail_t rail, bool on)
+{
+    const int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&power_lock);
+    if (on && active_since_us[rail] == 0) {
+        active_since_us[rail] = now;
+    } else if (!on && active_since_us[rail] != 0) {
+        active_us[rail] += now - active_since_us[rail];
+        active_since_us[rail] = 0;
+    }
+    portEXIT_CRITICAL(&power_lock);
+}
+
+void power_set_backlight(bool on)
+{
+    rail_set(ENERGY_BACKLIGHT, on);
+}
+
+void power_set_sensor_low_power(bool low_power)
+{
+    rail_set(ENERGY_SENSOR, !low_power);
+}
+
+void power_get_duty(energy_duty_t *duty)
+{
+    const int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&power_lock);
+    duty->elapsed_us = now - start_us;
+    for (int rail = 0; rail < ENERGY_RAIL_COUNT; rail++) {
+        duty->active_us[rail] = active_us[rail];
+        if (active_since_us[rail] != 0) {
+            duty->active_us[rail] += now - active_since_us[rail];
+        }
+    }
+    portEXIT_CRITICAL(&power_lock);
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    // Run time counter ticks are esp_timer microseconds. This is the idle
+    // task of the calling core; the firmware's tasks are not pinned, so
+    // it stands for the chip.
+    const uint64_t idle = ulTaskGetIdleRunTimeCounter() - start_idle;
+    duty->active_us[ENERGY_CPU] = idle < duty->elapsed_us ? duty->elapsed_us - idle : 0;
+#endif
+}
+
+void power_get_report(energy_report_t *report)
+{
+    energy_duty_t duty;
+
+    power_get_duty(&duty);
+    energy_model_estimate(&profile, &duty, report);
+}
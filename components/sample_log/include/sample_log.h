@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sample_store.h"
+
+// Append-only sample history in the "samplelog" flash partition.
+//
+// The partition is a ring of 4 KB sectors. Each sector starts with a header
+// holding a sequence number and a keyframe (time + values); the rest is
+// 8-byte records carrying time and value deltas from the previous sample.
+// Writing round-robin through every sector is the wear levelling.
+//
+// Samples are queued to a writer task that programs whole 256-byte flash
+// pages and erases the next sector while the current one is half full, so
+// neither the sample path nor a sector change waits for an erase. At boot
+// only sector headers are scanned to find the head, plus the sector after
+// it to see whether it is already erased.
+
+#define SAMPLE_LOG_PARTITION_LABEL "samplelog"
+#define SAMPLE_LOG_PARTITION_SUBTYPE 0x40
+
+typedef struct {
+    uint32_t records;           // samples written to flash
+    uint32_t dropped;           // samples lost to a full queue
+    uint32_t keyframes;         // sectors started
+    uint32_t sectors_erased;
+    uint64_t bytes_written;     // headers and records
+    uint64_t bytes_erased;
+    uint32_t boot_scan_us;
+    uint32_t restore_us;
+} sample_log_stats_t;
+
+typedef void (*sample_log_cb_t)(uint32_t time_s, const ts_point_t *point, void *ctx);
+
+// Locate the partition and its head. Must run before any other call.
+esp_err_t sample_log_init(void);
+
+// Replay the last `hours` of history, oldest first. Call before
+// sample_log_start().
+esp_err_t sample_log_restore(uint32_t hours, sample_log_cb_t cb, void *ctx);
+
+// Start the writer task. A shutdown handler programs the partial page
+// before esp_restart().
+esp_err_t sample_log_start(void);
+
+// Log clock: continues from the newest record across reboots
+uint32_t sample_log_time_s(void);
+
+// Queue a sample without blocking; returns false if it had to be dropped
+bool sample_log_append(uint32_t time_s, const ts_point_t *point);
+
+// Ask the writer to program any partially filled page
+void sample_log_flush(void);
+
+void sample_log_get_stats(sample_log_stats_t *stats);
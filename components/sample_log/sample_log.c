@@ -0,0 +1,455 @@
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_partition.h"
+#include "sample_log.h"
+
+static const char *TAG = "SAMPLE_LOG";
+
+#define SLOG_MAGIC          0x31474C53  // "SLG1"
+#define SLOG_SECTOR_SIZE    4096
+#define SLOG_PAGE_SIZE      256
+#define SLOG_HDR_SIZE       32
+#define SLOG_QUEUE_LEN      32
+#define SLOG_BOOT_GAP_S     5           // assumed time lost across a reboot
+#define SLOG_DT_EMPTY       0xFFFF      // erased flash
+#define SLOG_SHUTDOWN_WAIT_MS 200       // writer drain before a restart
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t base_time_s;
+    ts_point_t base;
+    uint16_t reserved;
+    uint32_t check;
+    uint8_t pad[SLOG_HDR_SIZE - 24];
+} slog_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t dt_s;
+    int16_t d_temp;
+    int16_t d_hum;
+    int16_t d_co2;
+} slog_record_t;
+
+typedef struct {
+    uint32_t time_s;
+    ts_point_t point;
+    bool flush;
+    TaskHandle_t waiter;        // notified once a flush is programmed
+} slog_item_t;
+
+typedef struct {
+    sample_log_cb_t cb;
+    void *ctx;
+    uint32_t count;
+    uint32_t first_s;
+    uint32_t last_s;
+} slog_replay_t;
+
+_Static_assert(sizeof(slog_hdr_t) == SLOG_HDR_SIZE, "header size");
+_Static_assert(sizeof(slog_record_t) == 8, "record size");
+_Static_assert((SLOG_SECTOR_SIZE - SLOG_HDR_SIZE) % sizeof(slog_record_t) == 0, "records fill sectors");
+
+static struct {
+    const esp_partition_t *part;
+    uint32_t sectors;
+    bool have_head;
+    uint32_t head;              // sector being written
+    uint32_t head_seq;
+    uint32_t write_off;         // offset of the next record in the head sector
+    uint32_t flushed_off;       // bytes of the head sector already programmed
+    bool next_erased;
+    uint8_t page[SLOG_PAGE_SIZE];
+
+    bool have_last;
+    uint32_t last_time_s;
+    ts_point_t last;
+
+    int64_t time_offset_s;
+    QueueHandle_t queue;
+    sample_log_stats_t stats;
+} s_log;
+
+static uint32_t hdr_check(const slog_hdr_t *hdr)
+{
+    // FNV-1a over everything before the check field
+    const uint8_t *b = (const uint8_t *)hdr;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(slog_hdr_t, check); i++) {
+        h = (h ^ b[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool read_hdr(uint32_t sector, slog_hdr_t *hdr)
+{
+    if (esp_partition_read(s_log.part, sector * SLOG_SECTOR_SIZE, hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    return hdr->magic == SLOG_MAGIC && hdr->check == hdr_check(hdr);
+}
+
+static ts_point_t apply_delta(const ts_point_t *p, const slog_record_t *r)
+{
+    return (ts_point_t) {
+        .temp_cdeg = (int16_t)(p->temp_cdeg + r->d_temp),
+        .hum_cpct = (uint16_t)(p->hum_cpct + r->d_hum),
+        .co2_ppm = (uint16_t)(p->co2_ppm + r->d_co2),
+    };
+}
+
+static bool fits_i16(int32_t v)
+{
+    return v >= INT16_MIN && v <= INT16_MAX;
+}
+
+static bool encode(uint32_t time_s, const ts_point_t *p, slog_record_t *r)
+{
+    if (time_s < s_log.last_time_s || time_s - s_log.last_time_s >= SLOG_DT_EMPTY) {
+        return false;
+    }
+    int32_t d_temp = p->temp_cdeg - s_log.last.temp_cdeg;
+    int32_t d_hum = p->hum_cpct - s_log.last.hum_cpct;
+    int32_t d_co2 = p->co2_ppm - s_log.last.co2_ppm;
+    if (!fits_i16(d_temp) || !fits_i16(d_hum) || !fits_i16(d_co2)) {
+        return false;
+    }
+    r->dt_s = (uint16_t)(time_s - s_log.last_time_s);
+    r->d_temp = (int16_t)d_temp;
+    r->d_hum = (int16_t)d_hum;
+    r->d_co2 = (int16_t)d_co2;
+    return true;
+}
+
+// Walk the records of one sector, calling cb for each sample at or after
+// `from_s`. Returns the offset just past the last valid record.
+static uint32_t decode_sector(uint32_t sector, const slog_hdr_t *hdr, uint32_t from_s,
+                              sample_log_cb_t cb, void *ctx)
+{
+    uint32_t time_s = hdr->base_time_s;
+    ts_point_t point = hdr->base;
+    uint32_t off = SLOG_HDR_SIZE;
+    uint8_t page[SLOG_PAGE_SIZE];
+
+    while (off < SLOG_SECTOR_SIZE) {
+        uint32_t page_base = off - off % SLOG_PAGE_SIZE;
+        if (esp_partition_read(s_log.part, sector * SLOG_SECTOR_SIZE + page_base, page, sizeof(page)) != ESP_OK) {
+            break;
+        }
+        for (; off < page_base + SLOG_PAGE_SIZE; off += sizeof(slog_record_t)) {
+            slog_record_t r;
+            memcpy(&r, &page[off - page_base], sizeof(r));
+            if (r.dt_s == SLOG_DT_EMPTY) {
+                goto done;
+            }
+            time_s += r.dt_s;
+            point = apply_delta(&point, &r);
+            if (cb && time_s >= from_s) {
+                cb(time_s, &point, ctx);
+            }
+        }
+    }
+done:
+    if (sector == s_log.head) {
+        s_log.last_time_s = time_s;
+        s_log.last = point;
+        s_log.have_last = true;
+    }
+    return off;
+}
+
+// Program the part of the current page that is not in flash yet
+static void flush_page(void)
+{
+    if (s_log.flushed_off == s_log.write_off) {
+        return;
+    }
+    uint32_t page_base = s_log.flushed_off - s_log.flushed_off % SLOG_PAGE_SIZE;
+    uint32_t len = s_log.write_off - s_log.flushed_off;
+    esp_err_t err = esp_partition_write(s_log.part, s_log.head * SLOG_SECTOR_SIZE + s_log.flushed_off,
+                                        &s_log.page[s_log.flushed_off - page_base], len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed: %s", esp_err_to_name(err));
+    }
+    s_log.stats.bytes_written += len;
+    s_log.flushed_off = s_log.write_off;
+}
+
+static void erase_sector(uint32_t sector)
+{
+    esp_err_t err = esp_partition_erase_range(s_log.part, sector * SLOG_SECTOR_SIZE, SLOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erase of sector %u failed: %s", (unsigned)sector, esp_err_to_name(err));
+    }
+    s_log.stats.sectors_erased++;
+    s_log.stats.bytes_erased += SLOG_SECTOR_SIZE;
+}
+
+// Open the next sector with (time_s, base) as its keyframe
+static void start_sector(uint32_t time_s, const ts_point_t *base)
+{
+    flush_page();
+
+    uint32_t next = s_log.have_head ? (s_log.head + 1) % s_log.sectors : 0;
+    if (!s_log.next_erased) {
+        erase_sector(next);
+    }
+
+    slog_hdr_t hdr = {
+        .magic = SLOG_MAGIC,
+        .seq = s_log.have_head ? s_log.head_seq + 1 : 1,
+        .base_time_s = time_s,
+        .base = *base,
+    };
+    memset(hdr.pad, 0xFF, sizeof(hdr.pad));
+    hdr.check = hdr_check(&hdr);
+
+    s_log.have_head = true;
+    s_log.head = next;
+    s_log.head_seq = hdr.seq;
+    s_log.next_erased = false;
+    s_log.flushed_off = 0;
+    s_log.write_off = SLOG_HDR_SIZE;
+    memcpy(s_log.page, &hdr, sizeof(hdr));
+    flush_page();
+
+    s_log.last_time_s = time_s;
+    s_log.last = *base;
+    s_log.have_last = true;
+    s_log.stats.keyframes++;
+}
+
+static void append(uint32_t time_s, const ts_point_t *p)
+{
+    slog_record_t r;
+
+    if (!s_log.have_head || s_log.write_off >= SLOG_SECTOR_SIZE) {
+        start_sector(s_log.have_last ? s_log.last_time_s : time_s, s_log.have_last ? &s_log.last : p);
+    }
+    if (!encode(time_s, p, &r)) {
+        // Gap or jump too large for a delta: key a fresh sector on this sample
+        start_sector(time_s, p);
+        encode(time_s, p, &r);
+    }
+
+    uint32_t page_base = s_log.write_off - s_log.write_off % SLOG_PAGE_SIZE;
+    memcpy(&s_log.page[s_log.write_off - page_base], &r, sizeof(r));
+    s_log.write_off += sizeof(r);
+    s_log.last_time_s = time_s;
+    s_log.last = *p;
+    s_log.stats.records++;
+
+    if (s_log.write_off % SLOG_PAGE_SIZE == 0) {
+        flush_page();
+    }
+    if (!s_log.next_erased && s_log.write_off >= SLOG_SECTOR_SIZE / 2) {
+        erase_sector((s_log.head + 1) % s_log.sectors);
+        s_log.next_erased = true;
+    }
+}
+
+// A sector erased ahead of time by the last run is all 0xFF; an erase cut
+// short by a reset is not, and is redone at the usual point
+static bool sector_erased(uint32_t sector)
+{
+    uint32_t words[SLOG_PAGE_SIZE / sizeof(uint32_t)];
+
+    for (uint32_t off = 0; off < SLOG_SECTOR_SIZE; off += sizeof(words)) {
+        if (esp_partition_read(s_log.part, sector * SLOG_SECTOR_SIZE + off, words, sizeof(words)) != ESP_OK) {
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+            if (words[i] != UINT32_MAX) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void sample_log_task(void *arg)
+{
+    slog_item_t item;
+
+    while (1) {
+        if (xQueueReceive(s_log.queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (item.flush) {
+            flush_page();
+            if (item.waiter) {
+                xTaskNotifyGive(item.waiter);
+            }
+        } else {
+            append(item.time_s, &item.point);
+        }
+    }
+}
+
+esp_err_t sample_log_init(void)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    s_log.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SAMPLE_LOG_PARTITION_SUBTYPE,
+                                          SAMPLE_LOG_PARTITION_LABEL);
+    if (!s_log.part) {
+        ESP_LOGE(TAG, "Partition '%s' not found", SAMPLE_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_log.sectors = s_log.part->size / SLOG_SECTOR_SIZE;
+    if (s_log.sectors < 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Boot index: the head is the valid sector with the highest sequence
+    slog_hdr_t hdr, head_hdr;
+    for (uint32_t i = 0; i < s_log.sectors; i++) {
+        if (read_hdr(i, &hdr) && (!s_log.have_head || hdr.seq > s_log.head_seq)) {
+            s_log.have_head = true;
+            s_log.head = i;
+            s_log.head_seq = hdr.seq;
+            head_hdr = hdr;
+        }
+    }
+
+    if (s_log.have_head) {
+        s_log.write_off = decode_sector(s_log.head, &head_hdr, UINT32_MAX, NULL, NULL);
+        s_log.flushed_off = s_log.write_off;
+        s_log.next_erased = sector_erased((s_log.head + 1) % s_log.sectors);
+        s_log.time_offset_s = (int64_t)s_log.last_time_s + SLOG_BOOT_GAP_S - start_us / 1000000;
+    }
+
+    s_log.queue = xQueueCreate(SLOG_QUEUE_LEN, sizeof(slog_item_t));
+    if (!s_log.queue) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_log.stats.boot_scan_us = (uint32_t)(esp_timer_get_time() - start_us);
+    ESP_LOGI(TAG, "%u sectors, head %u seq %u%s, last sample at %us (scan %u us)",
+             (unsigned)s_log.sectors, (unsigned)s_log.head, (unsigned)s_log.head_seq,
+             s_log.next_erased ? ", next erased" : "", (unsigned)s_log.last_time_s,
+             (unsigned)s_log.stats.boot_scan_us);
+    return ESP_OK;
+}
+
+static void replay_cb(uint32_t time_s, const ts_point_t *point, void *ctx)
+{
+    slog_replay_t *replay = ctx;
+
+    if (replay->count++ == 0) {
+        replay->first_s = time_s;
+    }
+    replay->last_s = time_s;
+    replay->cb(time_s, point, replay->ctx);
+}
+
+esp_err_t sample_log_restore(uint32_t hours, sample_log_cb_t cb, void *ctx)
+{
+    if (!s_log.part) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!s_log.have_head) {
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    uint32_t span_s = hours * 3600;
+    uint32_t from_s = s_log.last_time_s > span_s ? s_log.last_time_s - span_s : 0;
+
+    // Step back through consecutive sectors until one starts before from_s
+    slog_hdr_t hdr;
+    uint32_t first = s_log.head;
+    if (!read_hdr(first, &hdr)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (uint32_t k = 1; k < s_log.sectors && hdr.base_time_s > from_s; k++) {
+        uint32_t prev = (first + s_log.sectors - 1) % s_log.sectors;
+        slog_hdr_t prev_hdr;
+        if (!read_hdr(prev, &prev_hdr) || prev_hdr.seq != hdr.seq - 1) {
+            break;
+        }
+        first = prev;
+        hdr = prev_hdr;
+    }
+
+    slog_replay_t replay = {
+        .cb = cb,
+        .ctx = ctx,
+    };
+    for (uint32_t sector = first;; sector = (sector + 1) % s_log.sectors) {
+        if (read_hdr(sector, &hdr)) {
+            decode_sector(sector, &hdr, from_s, replay_cb, &replay);
+        }
+        if (sector == s_log.head) {
+            break;
+        }
+    }
+
+    s_log.stats.restore_us = (uint32_t)(esp_timer_get_time() - start_us);
+    ESP_LOGI(TAG, "Restored %u samples covering %u s in %u us", (unsigned)replay.count,
+             replay.count ? (unsigned)(replay.last_s - replay.first_s) : 0, (unsigned)s_log.stats.restore_us);
+    return ESP_OK;
+}
+
+// Queued samples are programmed before the flush, so a restart loses at
+// most what arrives while it waits
+static void shutdown_flush(void)
+{
+    slog_item_t item = {
+        .flush = true,
+        .waiter = xTaskGetCurrentTaskHandle(),
+    };
+    if (xQueueSend(s_log.queue, &item, pdMS_TO_TICKS(SLOG_SHUTDOWN_WAIT_MS)) == pdTRUE) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SLOG_SHUTDOWN_WAIT_MS));
+    }
+}
+
+esp_err_t sample_log_start(void)
+{
+    if (!s_log.queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xTaskCreate(sample_log_task, "sample_log", 3072, NULL, 2, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return esp_register_shutdown_handler(shutdown_flush);
+}
+
+uint32_t sample_log_time_s(void)
+{
+    return (uint32_t)(s_log.time_offset_s + esp_timer_get_time() / 1000000);
+}
+
+bool sample_log_append(uint32_t time_s, const ts_point_t *point)
+{
+    slog_item_t item = {
+        .time_s = time_s,
+        .point = *point,
+    };
+    if (!s_log.queue || xQueueSend(s_log.queue, &item, 0) != pdTRUE) {
+        s_log.stats.dropped++;
+        return false;
+    }
+    return true;
+}
+
+void sample_log_flush(void)
+{
+    slog_item_t item = {
+        .flush = true,
+    };
+    if (s_log.queue) {
+        xQueueSend(s_log.queue, &item, 0);
+    }
+}
+
+void sample_log_get_stats(sample_log_stats_t *stats)
+{
+    *stats = s_log.stats;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Multi-resolution sample history with a fixed compile-time footprint.
+//
+// The raw tier keeps every 5 s sample for the last hour. Each coarser tier
+// rolls samples up into min/avg/max buckets aligned to its period; buckets
+// with no samples (sensor errors, gaps) are kept with count 0 so that slot
+// position always maps to time. Adding a sample is O(tiers), reading any
+// entry is O(1) and a window summary is O(window).
+//
+// Raw samples are kept as one int32 ring per channel, so a channel can be
+// read in place, e.g. bound to a chart as its data, instead of copied.
+// That is 12 bytes a sample against the 6-byte ts_point_t the rest of the
+// pipeline passes around, and deliberately so. The raw ring has no
+// timestamps: it holds samples in arrival order, newest at the head. The
+// time deltas are kept in the flash log's 8-byte records (sample_log).
+//
+// Not thread-safe: callers serialise access.
+
+// Slots per tier; override from the build to trade history for RAM
+#ifndef SAMPLE_STORE_RAW_SLOTS
+#define SAMPLE_STORE_RAW_SLOTS   720    // 1 h of 5 s samples
+#endif
+#ifndef SAMPLE_STORE_1MIN_SLOTS
+#define SAMPLE_STORE_1MIN_SLOTS  720    // 12 h
+#endif
+#ifndef SAMPLE_STORE_15MIN_SLOTS
+#define SAMPLE_STORE_15MIN_SLOTS 672    // 7 days
+#endif
+#ifndef SAMPLE_STORE_1H_SLOTS
+#define SAMPLE_STORE_1H_SLOTS    168    // 7 days
+#endif
+
+// Raw slots not written yet; the same value as LV_CHART_POINT_NONE, so a
+// chart drawing the ring in place skips them
+#define SAMPLE_STORE_RAW_EMPTY   INT32_MAX
+
+typedef enum {
+    TS_TIER_RAW,
+    TS_TIER_1MIN,
+    TS_TIER_15MIN,
+    TS_TIER_1H,
+    TS_TIER_COUNT
+} ts_tier_t;
+
+typedef enum {
+    TS_CH_TEMP,     // centi-degrees C
+    TS_CH_HUM,      // centi-percent RH
+    TS_CH_CO2,      // ppm
+    TS_CHANNELS
+} ts_channel_t;
+
+// Fixed-point reading, 6 bytes
+typedef struct {
+    int16_t temp_cdeg;
+    uint16_t hum_cpct;
+    uint16_t co2_ppm;
+} ts_point_t;
+
+typedef struct {
+    ts_point_t min;
+    ts_point_t avg;
+    ts_point_t max;
+    uint16_t count;     // samples rolled into the bucket, 0 for a gap
+} ts_bucket_t;
+
+typedef struct {
+    int32_t min[TS_CHANNELS];
+    int32_t max[TS_CHANNELS];
+    int32_t sum[TS_CHANNELS];
+    uint16_t count;
+    uint32_t start_s;
+} ts_accum_t;
+
+typedef struct {
+    uint32_t head;      // slot of the next write
+    uint32_t count;
+} ts_ring_t;
+
+typedef struct {
+    int32_t raw[TS_CHANNELS][SAMPLE_STORE_RAW_SLOTS];
+    ts_bucket_t min1[SAMPLE_STORE_1MIN_SLOTS];
+    ts_bucket_t min15[SAMPLE_STORE_15MIN_SLOTS];
+    ts_bucket_t hour1[SAMPLE_STORE_1H_SLOTS];
+    ts_ring_t ring[TS_TIER_COUNT];
+    ts_accum_t accum[TS_TIER_COUNT];    // open bucket per tier; [TS_TIER_RAW] unused
+    bool started;
+} sample_store_t;
+
+void sample_store_init(sample_store_t *s);
+
+// time_s is a monotonic timestamp in seconds (e.g. seconds since boot)
+void sample_store_add(sample_store_t *s, uint32_t time_s, const ts_point_t *p);
+
+uint32_t sample_store_period_s(ts_tier_t tier);
+uint32_t sample_store_capacity(ts_tier_t tier);
+uint32_t sample_store_count(const sample_store_t *s, ts_tier_t tier);
+
+// Slot the next entry of a tier goes to; the newest is the one before it
+uint32_t sample_store_head(const sample_store_t *s, ts_tier_t tier);
+
+// Raw samples of one channel in place: SAMPLE_STORE_RAW_SLOTS values in
+// ring order, unwritten slots SAMPLE_STORE_RAW_EMPTY. Each slot is one
+// aligned 32-bit store, so a reader not holding the caller's lock sees the
+// old or the new value. Writable for APIs such as lv_chart's external
+// arrays that take a non-const pointer; only the store writes to it.
+int32_t *sample_store_raw_channel(sample_store_t *s, ts_channel_t ch);
+
+// Entry `age` of a tier, 0 being the newest completed one. Raw samples are
+// returned as a bucket with min == avg == max and count 1.
+bool sample_store_get(const sample_store_t *s, ts_tier_t tier, uint32_t age, ts_bucket_t *out);
+
+// The bucket still being filled on a coarse tier
+bool sample_store_partial(const sample_store_t *s, ts_tier_t tier, ts_bucket_t *out);
+
+// Min/avg/max across the newest n entries of a tier, skipping gaps
+bool sample_store_window(const sample_store_t *s, ts_tier_t tier, uint32_t n, ts_bucket_t *out);
+
+static inline int32_t ts_point_get(const ts_point_t *p, ts_channel_t ch)
+{
+    switch (ch) {
+        case TS_CH_TEMP: return p->temp_cdeg;
+        case TS_CH_HUM: return p->hum_cpct;
+        default: return p->co2_ppm;
+    }
+}
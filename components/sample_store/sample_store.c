@@ -0,0 +1,242 @@
+#include <string.h>
+#include "sample_store.h"
+
+static const uint32_t tier_period_s[TS_TIER_COUNT] = {
+    [TS_TIER_RAW] = 5,
+    [TS_TIER_1MIN] = 60,
+    [TS_TIER_15MIN] = 15 * 60,
+    [TS_TIER_1H] = 60 * 60,
+};
+
+static const uint32_t tier_slots[TS_TIER_COUNT] = {
+    [TS_TIER_RAW] = SAMPLE_STORE_RAW_SLOTS,
+    [TS_TIER_1MIN] = SAMPLE_STORE_1MIN_SLOTS,
+    [TS_TIER_15MIN] = SAMPLE_STORE_15MIN_SLOTS,
+    [TS_TIER_1H] = SAMPLE_STORE_1H_SLOTS,
+};
+
+static ts_bucket_t *tier_buckets(sample_store_t *s, ts_tier_t tier)
+{
+    switch (tier) {
+        case TS_TIER_1MIN: return s->min1;
+        case TS_TIER_15MIN: return s->min15;
+        case TS_TIER_1H: return s->hour1;
+        default: return NULL;
+    }
+}
+
+static const ts_bucket_t *tier_buckets_const(const sample_store_t *s, ts_tier_t tier)
+{
+    return tier_buckets((sample_store_t *)s, tier);
+}
+
+static ts_point_t point_from(const int32_t v[TS_CHANNELS])
+{
+    return (ts_point_t) {
+        .temp_cdeg = (int16_t)v[TS_CH_TEMP],
+        .hum_cpct = (uint16_t)v[TS_CH_HUM],
+        .co2_ppm = (uint16_t)v[TS_CH_CO2],
+    };
+}
+
+static uint32_t ring_push(ts_ring_t *r, uint32_t slots)
+{
+    uint32_t slot = r->head;
+    r->head = (r->head + 1) % slots;
+    if (r->count < slots) {
+        r->count++;
+    }
+    return slot;
+}
+
+static void accum_reset(ts_accum_t *a, uint32_t start_s)
+{
+    memset(a, 0, sizeof(*a));
+    a->start_s = start_s;
+}
+
+static void accum_add(ts_accum_t *a, const ts_point_t *p)
+{
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        int32_t v = ts_point_get(p, ch);
+        if (a->count == 0 || v < a->min[ch]) {
+            a->min[ch] = v;
+        }
+        if (a->count == 0 || v > a->max[ch]) {
+            a->max[ch] = v;
+        }
+        a->sum[ch] += v;
+    }
+    a->count++;
+}
+
+static ts_bucket_t accum_bucket(const ts_accum_t *a)
+{
+    ts_bucket_t b = {0};
+    if (a->count == 0) {
+        return b;
+    }
+    int32_t avg[TS_CHANNELS];
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        avg[ch] = (a->sum[ch] + (int32_t)a->count / 2) / (int32_t)a->count;
+    }
+    b.min = point_from(a->min);
+    b.avg = point_from(avg);
+    b.max = point_from(a->max);
+    b.count = a->count;
+    return b;
+}
+
+// Close the open bucket of a tier and any empty buckets up to `time_s`
+static void tier_roll(sample_store_t *s, ts_tier_t tier, uint32_t time_s)
+{
+    const uint32_t period = tier_period_s[tier];
+    const uint32_t slots = tier_slots[tier];
+    ts_accum_t *a = &s->accum[tier];
+    ts_bucket_t *buckets = tier_buckets(s, tier);
+    const uint32_t start = time_s - time_s % period;
+
+    if (start == a->start_s) {
+        return;
+    }
+
+    buckets[ring_push(&s->ring[tier], slots)] = accum_bucket(a);
+
+    // A gap longer than the whole tier only needs to clear it once
+    uint32_t gaps = (start - a->start_s) / period - 1;
+    if (gaps > slots) {
+        gaps = slots;
+    }
+    for (uint32_t i = 0; i < gaps; i++) {
+        buckets[ring_push(&s->ring[tier], slots)] = (ts_bucket_t) {0};
+    }
+    accum_reset(a, start);
+}
+
+void sample_store_init(sample_store_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        for (uint32_t i = 0; i < SAMPLE_STORE_RAW_SLOTS; i++) {
+            s->raw[ch][i] = SAMPLE_STORE_RAW_EMPTY;
+        }
+    }
+}
+
+void sample_store_add(sample_store_t *s, uint32_t time_s, const ts_point_t *p)
+{
+    const uint32_t slot = ring_push(&s->ring[TS_TIER_RAW], SAMPLE_STORE_RAW_SLOTS);
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        s->raw[ch][slot] = ts_point_get(p, ch);
+    }
+
+    for (ts_tier_t tier = TS_TIER_1MIN; tier < TS_TIER_COUNT; tier++) {
+        ts_accum_t *a = &s->accum[tier];
+        if (!s->started) {
+            accum_reset(a, time_s - time_s % tier_period_s[tier]);
+        } else if (time_s >= a->start_s + tier_period_s[tier]) {
+            tier_roll(s, tier, time_s);
+        }
+        accum_add(a, p);
+    }
+    s->started = true;
+}
+
+uint32_t sample_store_period_s(ts_tier_t tier)
+{
+    return tier < TS_TIER_COUNT ? tier_period_s[tier] : 0;
+}
+
+uint32_t sample_store_capacity(ts_tier_t tier)
+{
+    return tier < TS_TIER_COUNT ? tier_slots[tier] : 0;
+}
+
+uint32_t sample_store_count(const sample_store_t *s, ts_tier_t tier)
+{
+    return tier < TS_TIER_COUNT ? s->ring[tier].count : 0;
+}
+
+uint32_t sample_store_head(const sample_store_t *s, ts_tier_t tier)
+{
+    return tier < TS_TIER_COUNT ? s->ring[tier].head : 0;
+}
+
+int32_t *sample_store_raw_channel(sample_store_t *s, ts_channel_t ch)
+{
+    return s->raw[ch];
+}
+
+bool sample_store_get(const sample_store_t *s, ts_tier_t tier, uint32_t age, ts_bucket_t *out)
+{
+    if (tier >= TS_TIER_COUNT || age >= s->ring[tier].count) {
+        return false;
+    }
+
+    const uint32_t slots = tier_slots[tier];
+    const uint32_t slot = (s->ring[tier].head + slots - 1 - age) % slots;
+    if (tier == TS_TIER_RAW) {
+        const int32_t v[TS_CHANNELS] = {
+            [TS_CH_TEMP] = s->raw[TS_CH_TEMP][slot],
+            [TS_CH_HUM] = s->raw[TS_CH_HUM][slot],
+            [TS_CH_CO2] = s->raw[TS_CH_CO2][slot],
+        };
+        out->min = out->avg = out->max = point_from(v);
+        out->count = 1;
+    } else {
+        *out = tier_buckets_const(s, tier)[slot];
+    }
+    return true;
+}
+
+bool sample_store_partial(const sample_store_t *s, ts_tier_t tier, ts_bucket_t *out)
+{
+    if (tier == TS_TIER_RAW || tier >= TS_TIER_COUNT || s->accum[tier].count == 0) {
+        return false;
+    }
+    *out = accum_bucket(&s->accum[tier]);
+    return true;
+}
+
+bool sample_store_window(const sample_store_t *s, ts_tier_t tier, uint32_t n, ts_bucket_t *out)
+{
+    ts_accum_t a;
+    accum_reset(&a, 0);
+
+    // Weight bucket averages by their sample count
+    int64_t sum[TS_CHANNELS] = {0};
+    uint32_t samples = 0;
+
+    ts_bucket_t b;
+    for (uint32_t age = 0; age < n && sample_store_get(s, tier, age, &b); age++) {
+        if (b.count == 0) {
+            continue;
+        }
+        for (int ch = 0; ch < TS_CHANNELS; ch++) {
+            int32_t lo = ts_point_get(&b.min, ch);
+            int32_t hi = ts_point_get(&b.max, ch);
+            if (samples == 0 || lo < a.min[ch]) {
+                a.min[ch] = lo;
+            }
+            if (samples == 0 || hi > a.max[ch]) {
+                a.max[ch] = hi;
+            }
+            sum[ch] += (int64_t)ts_point_get(&b.avg, ch) * b.count;
+        }
+        samples += b.count;
+    }
+
+    if (samples == 0) {
+        return false;
+    }
+
+    int32_t avg[TS_CHANNELS];
+    for (int ch = 0; ch < TS_CHANNELS; ch++) {
+        avg[ch] = (int32_t)((sum[ch] + samples / 2) / samples);
+    }
+    out->min = point_from(a.min);
+    out->avg = point_from(avg);
+    out->max = point_from(a.max);
+    out->count = samples > UINT16_MAX ? UINT16_MAX : (uint16_t)samples;
+    return true;
+}
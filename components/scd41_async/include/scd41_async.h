@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+// SCD41 driver on the i2c_master API, fully asynchronous.
+//
+// Every bus operation is a queued i2c_master transaction whose completion
+// (ISR) arms an esp_timer for the next step, so no task ever blocks on the
+// bus or on the sensor's 1 ms command execution time. Each response word is
+// CRC-checked.
+//
+// Shortly before the next measurement is due the driver starts polling
+// get_data_ready_status every SCD41_ASYNC_POLL_MS and reads the
+// measurement on the first positive answer; the next poll window is timed
+// from that read, so the schedule follows the sensor's own clock.
+// Completed samples are queued for scd41_async_receive(). Transaction
+// latency, queued to done, goes to the "i2c" perf histogram.
+
+#define SCD41_ASYNC_I2C_ADDR        0x62
+#define SCD41_ASYNC_PERIOD_MS       5000    // standard periodic mode
+#define SCD41_ASYNC_LP_PERIOD_MS    30000   // low-power periodic mode
+#define SCD41_ASYNC_POLL_MS         20      // data-ready polling interval
+#define SCD41_ASYNC_POLL_LEAD_MS    100     // polling starts this early
+
+typedef struct {
+    int i2c_port;
+    int sda_gpio;
+    int scl_gpio;
+    uint32_t clk_hz;            // up to 400 kHz
+    bool low_power;             // low-power periodic mode, one sample per 30 s
+    // Read once per period after the previous read instead of polling for
+    // data-ready; the legacy schedule, kept to compare latency against
+    bool fixed_schedule;
+} scd41_async_cfg_t;
+
+#define SCD41_ASYNC_DEFAULT_CONFIG(sda, scl) \
+    {                                        \
+        .i2c_port = 0,                       \
+        .sda_gpio = (sda),                   \
+        .scl_gpio = (scl),                   \
+        .clk_hz = 400000,                    \
+        .low_power = false,                  \
+        .fixed_schedule = false,             \
+    }
+
+// Fixed-point, like ts_point_t
+typedef struct {
+    int16_t temp_cdeg;
+    uint16_t hum_cpct;
+    uint16_t co2_ppm;
+    int64_t ready_seen_us;      // first data-ready poll that saw it
+    int64_t read_us;            // measurement read and checked
+    bool low_power;             // measured in low-power periodic mode
+} scd41_sample_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t dropped;           // sample queue full
+    uint32_t transactions;
+    uint64_t bytes;             // on the bus, address bytes included
+    uint32_t polls;
+    uint32_t not_ready;         // polls (or fixed-schedule reads) too early
+    uint32_t crc_errors;
+    uint32_t bus_errors;        // NACK or timeout
+    // Upper bound of sensor-ready to read: ready happened after the last
+    // negative poll
+    uint32_t ready_window_us_last;
+    uint32_t ready_window_us_max;
+} scd41_async_stats_t;
+
+esp_err_t scd41_async_start(const scd41_async_cfg_t *cfg);
+
+// Switch between standard and low-power periodic mode. Takes effect
+// between samples: the driver stops periodic measurement before its next
+// data-ready poll and starts it again in the new mode, so no sample comes
+// for up to one period of each mode plus the 500 ms stop time.
+void scd41_async_set_low_power(bool low_power);
+
+// Wait for the next sample; false on timeout
+bool scd41_async_receive(scd41_sample_t *sample, TickType_t ticks);
+
+void scd41_async_get_stats(scd41_async_stats_t *stats);
@@ -0,0 +1,331 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+#include "perf.h"
+#include "scd41_async.h"
+
+static const char *TAG = "SCD41";
+
+#define CMD_START_PERIODIC          0x21B1
+#define CMD_START_LOW_POWER_PERIODIC 0x21AC
+#define CMD_STOP_PERIODIC           0x3F86
+#define CMD_GET_DATA_READY          0xE4B8
+#define CMD_READ_MEASUREMENT        0xEC05
+
+#define CMD_EXEC_US                 1000    // between a read command and its data
+#define STOP_EXEC_MS                500
+#define BUS_ERROR_RETRY_MS          1000
+#define SAMPLE_QUEUE_LEN            4
+#define TRANS_QUEUE_DEPTH           4
+
+// Next thing the step timer does
+typedef enum {
+    OP_STOP,            // after a reset, or to change the periodic mode
+    OP_START,
+    OP_POLL_CMD,
+    OP_POLL_DATA,
+    OP_POLL_CHECK,
+    OP_READ_DATA,
+    OP_READ_CHECK,
+} op_t;
+
+static scd41_async_cfg_t cfg;
+static i2c_master_bus_handle_t bus = NULL;
+static i2c_master_dev_handle_t dev = NULL;
+static esp_timer_handle_t step_timer = NULL;
+static QueueHandle_t sample_queue = NULL;
+
+// Owned by whichever of the step timer or the transfer-done ISR is active;
+// the two never run at once because each arms the other
+static volatile op_t next_op;
+static volatile op_t bus_op;            // step that started the transfer in flight
+static volatile op_t done_op;           // step after it completes
+static volatile uint32_t done_delay_us;
+static volatile bool want_low_power;    // applied by the step timer
+static uint8_t tx_buf[2];
+static uint8_t rx_buf[9];
+static int64_t last_not_ready_us;
+static int64_t ready_seen_us;
+static int64_t trans_start_us;          // for the "i2c" latency histogram
+static perf_hist_t *trans_hist = NULL;
+static scd41_async_stats_t stats;
+
+static uint32_t period_ms(void)
+{
+    return cfg.low_power ? SCD41_ASYNC_LP_PERIOD_MS : SCD41_ASYNC_PERIOD_MS;
+}
+
+// CRC-8, polynomial 0x31, init 0xFF, over one 16-bit word
+static uint8_t crc8(const uint8_t *data)
+{
+    uint8_t crc = 0xFF;
+
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Checks `words` CRC-protected words in rx_buf and unpacks them
+static bool rx_words(uint16_t *out, int words)
+{
+    for (int i = 0; i < words; i++) {
+        const uint8_t *w = &rx_buf[i * 3];
+        if (crc8(w) != w[2]) {
+            stats.crc_errors++;
+            return false;
+        }
+        out[i] = (uint16_t)((w[0] << 8) | w[1]);
+    }
+    return true;
+}
+
+static void step_after(op_t op, uint64_t delay_us)
+{
+    next_op = op;
+    esp_timer_stop(step_timer);
+    esp_timer_start_once(step_timer, delay_us);
+}
+
+// Where to go after a failed transfer. A NACKed stop just means the
+// sensor was idle already; a failed start is retried, anything else
+// resumes polling.
+static op_t IRAM_ATTR bus_failed(void)
+{
+    if (bus_op == OP_STOP) {
+        return OP_START;
+    }
+    stats.bus_errors++;
+    return bus_op == OP_START ? OP_START : OP_POLL_CMD;
+}
+
+static bool IRAM_ATTR trans_done(i2c_master_dev_handle_t i2c_dev, const i2c_master_event_data_t *evt, void *arg)
+{
+    if (evt->event == I2C_EVENT_DONE) {
+        perf_hist_add(trans_hist, (uint32_t)(esp_timer_get_time() - trans_start_us));
+        next_op = done_op;
+        esp_timer_start_once(step_timer, done_delay_us);
+    } else if (evt->event == I2C_EVENT_NACK || evt->event == I2C_EVENT_TIMEOUT) {
+        next_op = bus_failed();
+        esp_timer_start_once(step_timer, BUS_ERROR_RETRY_MS * 1000);
+    }
+    return false;
+}
+
+static void send_cmd(uint16_t cmd, op_t then, uint32_t delay_us)
+{
+    tx_buf[0] = cmd >> 8;
+    tx_buf[1] = cmd & 0xff;
+    done_op = then;
+    done_delay_us = delay_us;
+    stats.transactions++;
+    stats.bytes += 1 + sizeof(tx_buf);
+    trans_start_us = esp_timer_get_time();
+    if (i2c_master_transmit(dev, tx_buf, sizeof(tx_buf), -1) != ESP_OK) {
+        step_after(bus_failed(), BUS_ERROR_RETRY_MS * 1000);
+    }
+}
+
+static void receive(size_t len, op_t then)
+{
+    done_op = then;
+    done_delay_us = 0;
+    stats.transactions++;
+    stats.bytes += 1 + len;
+    trans_start_us = esp_timer_get_time();
+    if (i2c_master_receive(dev, rx_buf, len, -1) != ESP_OK) {
+        step_after(bus_failed(), BUS_ERROR_RETRY_MS * 1000);
+    }
+}
+
+// After a sample: either wait a whole period (legacy), or come back just
+// before the sensor's next measurement and poll for it
+static void schedule_next(void)
+{
+    if (cfg.fixed_schedule) {
+        step_after(OP_POLL_CMD, (uint64_t)period_ms() * 1000);
+    } else {
+        const int64_t due = ready_seen_us + (int64_t)(period_ms() - SCD41_ASYNC_POLL_LEAD_MS) * 1000;
+        const int64_t now = esp_timer_get_time();
+        step_after(OP_POLL_CMD, due > now ? (uint64_t)(due - now) : 0);
+    }
+}
+
+static void poll_check(void)
+{
+    uint16_t status;
+
+    if (!rx_words(&status, 1)) {
+        step_after(OP_POLL_CMD, SCD41_ASYNC_POLL_MS * 1000);
+        return;
+    }
+    // Lower 11 bits all zero: no new measurement
+    if ((status & 0x07FF) == 0) {
+        stats.not_ready++;
+        last_not_ready_us = esp_timer_get_time();
+        if (cfg.fixed_schedule) {
+            schedule_next();
+        } else {
+            step_after(OP_POLL_CMD, SCD41_ASYNC_POLL_MS * 1000);
+        }
+        return;
+    }
+
+    ready_seen_us = esp_timer_get_time();
+    if (last_not_ready_us != 0) {
+        const uint32_t window = (uint32_t)(ready_seen_us - last_not_ready_us);
+        stats.ready_window_us_last = window;
+        if (window > stats.ready_window_us_max) {
+            stats.ready_window_us_max = window;
+        }
+    }
+    send_cmd(CMD_READ_MEASUREMENT, OP_READ_DATA, CMD_EXEC_US);
+}
+
+static void read_check(void)
+{
+    uint16_t words[3];
+
+    if (!rx_words(words, 3)) {
+        schedule_next();
+        return;
+    }
+
+    // T = -45 + 175 * raw / 65535, RH = 100 * raw / 65535, in hundredths
+    const scd41_sample_t sample = {
+        .co2_ppm = words[0],
+        .temp_cdeg = (int16_t)(-4500 + (int32_t)((17500u * words[1] + 32767) / 65535)),
+        .hum_cpct = (uint16_t)((10000u * words[2] + 32767) / 65535),
+        .ready_seen_us = ready_seen_us,
+        .read_us = esp_timer_get_time(),
+        .low_power = cfg.low_power,
+    };
+
+    stats.samples++;
+    if (xQueueSend(sample_queue, &sample, 0) != pdTRUE) {
+        stats.dropped++;
+    }
+    last_not_ready_us = 0;
+    schedule_next();
+}
+
+// esp_timer task: one bus operation per step
+static void step_cb(void *arg)
+{
+    if (next_op == OP_POLL_CMD && want_low_power != cfg.low_power) {
+        // Between samples: restart periodic measurement in the other mode
+        cfg.low_power = want_low_power;
+        last_not_ready_us = 0;
+        next_op = OP_STOP;
+    }
+    bus_op = next_op;
+    switch (next_op) {
+        case OP_STOP:
+            send_cmd(CMD_STOP_PERIODIC, OP_START, STOP_EXEC_MS * 1000);
+            break;
+        case OP_START:
+            ESP_LOGI(TAG, "Starting %s periodic measurement", cfg.low_power ? "low-power" : "standard");
+            send_cmd(cfg.low_power ? CMD_START_LOW_POWER_PERIODIC : CMD_START_PERIODIC,
+                     OP_POLL_CMD, (period_ms() - (cfg.fixed_schedule ? 0 : SCD41_ASYNC_POLL_LEAD_MS)) * 1000);
+            break;
+        case OP_POLL_CMD:
+            stats.polls++;
+            send_cmd(CMD_GET_DATA_READY, OP_POLL_DATA, CMD_EXEC_US);
+            break;
+        case OP_POLL_DATA:
+            receive(3, OP_POLL_CHECK);
+            break;
+        case OP_POLL_CHECK:
+            poll_check();
+            break;
+        case OP_READ_DATA:
+            receive(9, OP_READ_CHECK);
+            break;
+        case OP_READ_CHECK:
+            read_check();
+            break;
+    }
+}
+
+esp_err_t scd41_async_start(const scd41_async_cfg_t *config)
+{
+    if (!config || config->clk_hz == 0 || config->clk_hz > 400000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cfg = *config;
+    want_low_power = cfg.low_power;
+    trans_hist = perf_hist_register("i2c");
+
+    sample_queue = xQueueCreate(SAMPLE_QUEUE_LEN, sizeof(scd41_sample_t));
+    if (!sample_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const i2c_master_bus_config_t bus_config = {
+        .i2c_port = cfg.i2c_port,
+        .sda_io_num = cfg.sda_gpio,
+        .scl_io_num = cfg.scl_gpio,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .trans_queue_depth = TRANS_QUEUE_DEPTH,
+        .flags.enable_internal_pullup = true,
+    };
+    esp_err_t err = i2c_new_master_bus(&bus_config, &bus);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create I2C bus: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    const i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = SCD41_ASYNC_I2C_ADDR,
+        .scl_speed_hz = cfg.clk_hz,
+    };
+    err = i2c_master_bus_add_device(bus, &dev_config, &dev);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SCD41: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    const i2c_master_event_callbacks_t cbs = {
+        .on_trans_done = trans_done,
+    };
+    err = i2c_master_register_event_callbacks(dev, &cbs, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = step_cb,
+        .name = "scd41",
+    };
+    err = esp_timer_create(&timer_args, &step_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    step_after(OP_STOP, 0);
+    return ESP_OK;
+}
+
+void scd41_async_set_low_power(bool low_power)
+{
+    want_low_power = low_power;
+}
+
+bool scd41_async_receive(scd41_sample_t *sample, TickType_t ticks)
+{
+    return xQueueReceive(sample_queue, sample, ticks) == pdTRUE;
+}
+
+void scd41_async_get_stats(scd41_async_stats_t *out)
+{
+    *out = stats;
+}
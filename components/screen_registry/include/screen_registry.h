@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+// Screens built when first loaded rather than all at boot.
+//
+// A screen is built by its create function when it is first loaded. Once
+// a load has been rendered, the screen after it is built in the following
+// handler pass, so the next press finds it ready. Before anything is
+// built, screens other than the active one are deleted, least recently
+// shown first, while the largest free block of the LVGL heap is below the
+// reserve; they are built again on their next load. A create function
+// must therefore restore everything its screen shows, e.g. from subjects
+// and the sample history, and whoever keeps pointers into a screen clears
+// them on its LV_EVENT_DELETE.
+//
+// Build times go into the "screen_build" perf histogram, and the time
+// since boot and the LVGL heap peak are logged when the first load has
+// been rendered. Everything runs in the LVGL task.
+
+#define SCREEN_REGISTRY_MAX 8
+
+typedef struct {
+    const char *name;
+    lv_obj_t *(*create)(void *ctx);     // the new screen, NULL on failure
+    void *ctx;
+} screen_desc_t;
+
+typedef struct {
+    uint32_t builds;                    // prebuilds included
+    uint32_t prebuilds;
+    uint32_t evictions;
+    uint32_t build_us_max;
+    uint8_t built;                      // screens currently in the LVGL heap
+    int64_t first_frame_us;             // esp_timer time the first load was rendered, 0 before
+    uint32_t first_frame_heap_peak;     // LVGL heap high-water mark at that point
+} screen_registry_stats_t;
+
+// `screens` must outlive the registry. A reserve of 0 never evicts.
+// Call with the LVGL lock held.
+esp_err_t screen_registry_init(lv_display_t *disp, const screen_desc_t *screens, int count,
+                               uint32_t reserve_bytes);
+
+// Build the screen if needed and load it. NULL if it could not be built;
+// the active screen stays.
+lv_obj_t *screen_registry_load(int index);
+
+// Build without loading, e.g. everything at boot
+lv_obj_t *screen_registry_build(int index);
+
+// The screen if it is built, else NULL
+lv_obj_t *screen_registry_get(int index);
+
+void screen_registry_get_stats(screen_registry_stats_t *stats);
@@ -0,0 +1,160 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "perf.h"
+#include "screen_registry.h"
+
+static const char *TAG = "SCREENS";
+
+typedef struct {
+    lv_obj_t *obj;
+    uint32_t shown;                     // load sequence number, 0 never shown
+} screen_slot_t;
+
+static lv_display_t *display = NULL;
+static const screen_desc_t *descs = NULL;
+static int desc_count = 0;
+static uint32_t reserve = 0;
+static screen_slot_t slots[SCREEN_REGISTRY_MAX];
+static uint32_t load_seq = 0;
+static int prebuild_pending = -1;       // screen to build after the next render
+static screen_registry_stats_t stats;
+static perf_hist_t *build_hist = NULL;
+
+static uint32_t heap_largest_free(void)
+{
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+    return mon.free_biggest_size;
+}
+
+static void screen_delete_cb(lv_event_t *e)
+{
+    screen_slot_t *slot = lv_event_get_user_data(e);
+
+    slot->obj = NULL;
+    stats.built--;
+}
+
+// Least recently shown first; never the active screen or `keep`
+static void make_room(int keep)
+{
+    lv_obj_t *active = lv_display_get_screen_active(display);
+
+    while (reserve > 0 && heap_largest_free() < reserve) {
+        int victim = -1;
+        for (int i = 0; i < desc_count; i++) {
+            if (i == keep || slots[i].obj == NULL || slots[i].obj == active) {
+                continue;
+            }
+            if (victim < 0 || slots[i].shown < slots[victim].shown) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return;
+        }
+        ESP_LOGI(TAG, "Evicting %s screen, %u bytes free", descs[victim].name, (unsigned)heap_largest_free());
+        lv_obj_delete(slots[victim].obj);
+        stats.evictions++;
+    }
+}
+
+lv_obj_t *screen_registry_build(int index)
+{
+    if (index < 0 || index >= desc_count) {
+        return NULL;
+    }
+    if (slots[index].obj != NULL) {
+        return slots[index].obj;
+    }
+
+    make_room(index);
+
+    const uint32_t start = perf_cycles();
+    lv_obj_t *obj = descs[index].create(descs[index].ctx);
+    const uint32_t us = perf_cycles_to_us(perf_cycles() - start);
+
+    if (obj == NULL) {
+        ESP_LOGE(TAG, "Could not build %s screen", descs[index].name);
+        return NULL;
+    }
+    slots[index].obj = obj;
+    lv_obj_add_event_cb(obj, screen_delete_cb, LV_EVENT_DELETE, &slots[index]);
+    stats.builds++;
+    stats.built++;
+    if (us > stats.build_us_max) {
+        stats.build_us_max = us;
+    }
+    perf_hist_add(build_hist, us);
+    ESP_LOGD(TAG, "Built %s screen in %u us", descs[index].name, (unsigned)us);
+    return obj;
+}
+
+static void prebuild_cb(void *arg)
+{
+    const int index = prebuild_pending;
+
+    prebuild_pending = -1;
+    if (index >= 0 && slots[index].obj == NULL && screen_registry_build(index) != NULL) {
+        stats.prebuilds++;
+    }
+}
+
+// The loaded screen is on its way to the panel; build the next one in
+// the following pass so this one is not held up
+static void refr_ready_cb(lv_event_t *e)
+{
+    if (load_seq > 0 && stats.first_frame_us == 0) {
+        lv_mem_monitor_t mon;
+
+        lv_mem_monitor(&mon);
+        stats.first_frame_us = esp_timer_get_time();
+        stats.first_frame_heap_peak = mon.max_used;
+        ESP_LOGI(TAG, "First frame %lld ms after boot, LVGL heap peak %u bytes",
+                 (long long)(stats.first_frame_us / 1000), (unsigned)mon.max_used);
+    }
+    if (prebuild_pending >= 0) {
+        lv_async_call(prebuild_cb, NULL);
+    }
+}
+
+lv_obj_t *screen_registry_load(int index)
+{
+    lv_obj_t *obj = screen_registry_build(index);
+
+    if (obj == NULL) {
+        return NULL;
+    }
+    slots[index].shown = ++load_seq;
+    lv_screen_load(obj);
+
+    const int next = (index + 1) % desc_count;
+    prebuild_pending = slots[next].obj == NULL ? next : -1;
+    return obj;
+}
+
+lv_obj_t *screen_registry_get(int index)
+{
+    return index >= 0 && index < desc_count ? slots[index].obj : NULL;
+}
+
+esp_err_t screen_registry_init(lv_display_t *disp, const screen_desc_t *screens, int count,
+                               uint32_t reserve_bytes)
+{
+    if (disp == NULL || count <= 0 || count > SCREEN_REGISTRY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    display = disp;
+    descs = screens;
+    desc_count = count;
+    reserve = reserve_bytes;
+    build_hist = perf_hist_register("screen_build");
+    lv_display_add_event_cb(disp, refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+    return ESP_OK;
+}
+
+void screen_registry_get_stats(screen_registry_stats_t *out)
+{
+    *out = stats;
+}
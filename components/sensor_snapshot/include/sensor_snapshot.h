@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sample_store.h"
+
+// Latest sample plus its derived statistics, shared between one writer and
+// any number of readers through a seqlock.
+//
+// The writer never waits: it bumps the sequence to odd, stores the words
+// and bumps it back to even. A reader copies the words and retries if the
+// sequence was odd or moved meanwhile. Retries are bounded so a reader that
+// preempts the writer mid-update on the same core cannot spin forever; it
+// then reports failure and keeps what it had.
+
+typedef struct {
+    uint32_t count;         // samples published so far, 0 before the first
+    uint32_t time_s;        // sample_log_time_s() of `latest`
+    ts_point_t latest;
+    ts_point_t min;         // window extrema
+    ts_point_t max;
+    uint16_t reserved;
+} sensor_snapshot_t;
+
+#define SENSOR_SNAPSHOT_WORDS (sizeof(sensor_snapshot_t) / sizeof(uint32_t))
+
+_Static_assert(sizeof(sensor_snapshot_t) % sizeof(uint32_t) == 0, "snapshot must be whole words");
+
+typedef struct {
+    atomic_uint seq;
+    atomic_uint words[SENSOR_SNAPSHOT_WORDS];
+} sensor_snapshot_cell_t;
+
+#define SENSOR_SNAPSHOT_READ_TRIES 8
+
+void sensor_snapshot_init(sensor_snapshot_cell_t *cell);
+
+// Single writer only
+void sensor_snapshot_publish(sensor_snapshot_cell_t *cell, const sensor_snapshot_t *snap);
+
+// Consistent copy into `out`; false if none could be taken within
+// SENSOR_SNAPSHOT_READ_TRIES, in which case `out` is left unchanged
+bool sensor_snapshot_read(sensor_snapshot_cell_t *cell, sensor_snapshot_t *out);
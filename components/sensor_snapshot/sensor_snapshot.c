@@ -0,0 +1,45 @@
+#include <string.h>
+#include "sensor_snapshot.h"
+
+void sensor_snapshot_init(sensor_snapshot_cell_t *cell)
+{
+    atomic_init(&cell->seq, 0);
+    for (size_t i = 0; i < SENSOR_SNAPSHOT_WORDS; i++) {
+        atomic_init(&cell->words[i], 0);
+    }
+}
+
+void sensor_snapshot_publish(sensor_snapshot_cell_t *cell, const sensor_snapshot_t *snap)
+{
+    uint32_t words[SENSOR_SNAPSHOT_WORDS];
+    memcpy(words, snap, sizeof(words));
+
+    unsigned seq = atomic_load_explicit(&cell->seq, memory_order_relaxed);
+    atomic_store_explicit(&cell->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < SENSOR_SNAPSHOT_WORDS; i++) {
+        atomic_store_explicit(&cell->words[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&cell->seq, seq + 2, memory_order_release);
+}
+
+bool sensor_snapshot_read(sensor_snapshot_cell_t *cell, sensor_snapshot_t *out)
+{
+    uint32_t words[SENSOR_SNAPSHOT_WORDS];
+
+    for (int tries = 0; tries < SENSOR_SNAPSHOT_READ_TRIES; tries++) {
+        unsigned begin = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if (begin & 1) {
+            continue;
+        }
+        for (size_t i = 0; i < SENSOR_SNAPSHOT_WORDS; i++) {
+            words[i] = atomic_load_explicit(&cell->words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&cell->seq, memory_order_relaxed) == begin) {
+            memcpy(out, words, sizeof(words));
+            return true;
+        }
+    }
+    return false;
+}
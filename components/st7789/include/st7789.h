@@ -1,5 +1,4 @@
 #include "lvgl.h"
-#include "esp_lvgl_port.h"
 // Display configuration - adjust these to match your setup
 #define LCD_HOST           SPI2_HOST
 #define LCD_PIXEL_CLK_HZ   (40 * 1000 * 1000)
@@ -25,9 +24,58 @@
 #define LV_DISP_ROT_270    3
 
 // LVGL settings
-#define LVGL_TICK_PERIOD_MS 2
 #define LVGL_BUFFER_HEIGHT  50
 
+// Flush engine counters. Bytes include the CASET/RASET/RAMWR command and
+// parameter bytes, i.e. everything clocked out on the bus.
+typedef struct {
+    uint32_t frames;                // render passes fully sent
+    uint32_t areas;
+    uint64_t bytes;
+    uint32_t transactions;
+    uint32_t last_frame_areas;
+    uint32_t last_frame_bytes;
+    uint32_t last_frame_us;         // first area queued to last pixel out
+    uint32_t last_frame_mbps_x100;  // achieved throughput of that frame
+} st7789_flush_stats_t;
+
+// Build with ST7789_SW_ROTATE=1 to render at the native 240x320 and rotate
+// each flushed area with lv_draw_sw_rotate instead; the host builds it as
+// scd41_lcd_sim_swrot
+#ifndef ST7789_SW_ROTATE
+#define ST7789_SW_ROTATE 0
+#endif
+
 void init_lcd(int rotation);
-void create_label(const lv_font_t *font, int x, int y, char *text);
+
+// Change rotation at runtime by reprogramming MADCTL and resizing the LVGL
+// display. Call with the LVGL lock held.
+void st7789_set_rotation(int rotation);
+void st7789_get_flush_stats(st7789_flush_stats_t *stats);
+
+// Hardware-scrolled strip for plots that move left by whole columns.
+// Logical columns [x, x + width) of a landscape display become the panel's
+// vertical scroll area (VSCRDEF), which then runs along the x axis, and
+// moving them left by `columns` is one VSCSAD write instead of a redraw:
+// the caller invalidates only the `columns` exposed at the right edge.
+// Everything in those columns scrolls, so the band must hold nothing but
+// the caller's widget, over the full height. Flushed areas are remapped to
+// where the scrolled memory keeps them, so any part can still be redrawn.
+// Call with the LVGL lock held; the panel follows at the next render pass.
+// ESP_ERR_INVALID_STATE in portrait or while the panel is off,
+// ESP_ERR_NOT_SUPPORTED with ST7789_SW_ROTATE.
+esp_err_t st7789_strip_scroll(int x, int width, int columns);
+
+// Back to an unscrolled screen, e.g. before loading another screen. Also
+// done on rotation. Call with the LVGL lock held.
+void st7789_strip_stop(void);
+
+// Screen off: backlight off, rendering suspended and the controller in
+// SLPIN. Screen on: SLPOUT now, then after the 120 ms SLPOUT delay an LVGL
+// timer redraws the whole screen and turns the backlight on; this does not
+// block. Widgets updated before that timer appear in the first frame.
+// Takes the LVGL lock, which is recursive, so it can also be called from
+// the LVGL task.
+void st7789_set_power(bool on);
+void create_label(const lv_font_t *font, lv_color_t color, int x, int y, char *text);
 void create_background(void);
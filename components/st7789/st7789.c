@@ -1,18 +1,296 @@
 #include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
-#include "esp_lvgl_port.h"
 #include "lvgl.h"
+#include "lvgl_sched.h"
+#include "perf.h"
 #include "st7789.h"
 
 static const char *TAG = "LVGL_DEMO";
 
+#define LCD_CMD_CASET      0x2A
+#define LCD_CMD_RASET      0x2B
+#define LCD_CMD_RAMWR      0x2C
+#define LCD_CMD_VSCRDEF    0x33
+#define LCD_CMD_VSCSAD     0x37
+#define LCD_TRANS_QUEUE    10
+#define LCD_SLPOUT_DELAY_MS 120
+
 static lv_disp_t *lvgl_disp = NULL;
+static esp_lcd_panel_io_handle_t lcd_io = NULL;
+static esp_lcd_panel_handle_t lcd_panel = NULL;
+static int lcd_rotation = LV_DISP_ROT_NONE;
+static bool lcd_powered = true;
+static lv_timer_t *wake_timer = NULL;      // SLPOUT sent, redraw pending
+
+// One area is on the bus at a time. LVGL hands over an area per draw
+// buffer and, before the next flush_cb, waits in flush_wait_cb for the
+// previous one to be out, so the window of the next area finds the bus
+// idle and the done callback only counts down the current area. Queueing
+// areas deeper would take more than two draw buffers of DMA memory.
+static struct {
+#if ST7789_SW_ROTATE
+    uint8_t *rotate_buf;
+#endif
+    SemaphoreHandle_t done;     // given when an area's last pixels are out
+    volatile uint32_t pending;  // pixel transactions of the area still queued
+    bool area_last;             // the area is the last of its render pass
+    int64_t frame_start_us;
+    uint32_t frame_bytes;
+    uint32_t frame_areas;
+    bool frame_open;
+    st7789_flush_stats_t stats;
+    perf_hist_t *frame_hist;
+} flush;
+
+// Hardware-scrolled strip. In landscape the panel's vertical scroll axis
+// is the logical x axis, so a band of columns can move left on the glass
+// without being sent again. Only the LVGL task changes this; the panel
+// follows at the start of the next render pass, together with the pixels
+// that fill the columns the scroll exposed.
+static struct {
+    bool active;
+    int x, width;       // logical band
+    int offset;         // glass column x + i shows memory column x + (i + offset) % width
+    bool dirty;         // not sent to the panel yet
+    uint8_t sent_def[6];
+} strip;
+
+// Runs in the SPI ISR on hardware, once per tx_color, and has to stay in
+// IRAM with everything it calls: sample_log erases and programs flash at
+// runtime, with the cache disabled. So no LVGL call here; after the area's
+// last pixels it accounts the frame and releases flush_wait_cb.
+static bool IRAM_ATTR flush_tx_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata,
+                                    void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (flush.pending == 0 || --flush.pending > 0) {
+        return false;
+    }
+    if (flush.area_last) {
+        uint32_t us = (uint32_t)(esp_timer_get_time() - flush.frame_start_us);
+        flush.stats.frames++;
+        flush.stats.last_frame_bytes = flush.frame_bytes;
+        flush.stats.last_frame_areas = flush.frame_areas;
+        flush.stats.last_frame_us = us;
+        perf_hist_add(flush.frame_hist, us);
+        flush.frame_open = false;
+    }
+    xSemaphoreGiveFromISR(flush.done, &woken);
+    return woken == pdTRUE;
+}
+
+// LVGL calls this, in its task, before reusing a draw buffer that was
+// flushed
+static void flush_wait_cb(lv_display_t *disp)
+{
+    xSemaphoreTake(flush.done, portMAX_DELAY);
+}
+
+// VSCRDEF/VSCSAD for the current strip. Memory row r holds logical column
+// r at 90 degrees and 319 - r at 270, hence the mirrored band.
+static void strip_apply(void)
+{
+    uint16_t tfa = 0;
+    uint16_t vsa = LCD_V_RES;
+    uint16_t vsp = 0;
+
+    if (strip.active) {
+        vsa = strip.width;
+        if (lcd_rotation == LV_DISP_ROT_90) {
+            tfa = strip.x;
+            vsp = tfa + strip.offset;
+        } else {
+            tfa = LCD_V_RES - strip.x - strip.width;
+            vsp = tfa + (strip.width - strip.offset) % strip.width;
+        }
+    }
+    const uint16_t bfa = LCD_V_RES - tfa - vsa;
+    const uint8_t def[6] = {tfa >> 8, tfa & 0xff, vsa >> 8, vsa & 0xff, bfa >> 8, bfa & 0xff};
+    const uint8_t sad[2] = {vsp >> 8, vsp & 0xff};
+    uint32_t bytes = 1 + sizeof(sad);
+
+    // Polling, so both wait for the previous frame's queued pixels and
+    // ordering holds. Deliberately synchronous: this runs once per render
+    // pass after a scroll.
+    if (memcmp(def, strip.sent_def, sizeof(def)) != 0) {
+        esp_lcd_panel_io_tx_param(lcd_io, LCD_CMD_VSCRDEF, def, sizeof(def));
+        memcpy(strip.sent_def, def, sizeof(def));
+        bytes += 1 + sizeof(def);
+        flush.stats.transactions++;
+    }
+    esp_lcd_panel_io_tx_param(lcd_io, LCD_CMD_VSCSAD, sad, sizeof(sad));
+    flush.stats.transactions++;
+    flush.stats.bytes += bytes;
+    flush.frame_bytes += bytes;
+    strip.dirty = false;
+}
+
+// Logical column to the panel memory column that holds it
+static int strip_column(int x)
+{
+    if (!strip.active || x < strip.x || x >= strip.x + strip.width) {
+        return x;
+    }
+    return strip.x + (x - strip.x + strip.offset) % strip.width;
+}
+
+// Whether an area's columns stay one contiguous run in panel memory
+static bool strip_contiguous(const lv_area_t *area)
+{
+    if (!strip.active || strip.offset == 0 || area->x2 < strip.x || area->x1 >= strip.x + strip.width) {
+        return true;
+    }
+    return area->x1 >= strip.x && area->x2 < strip.x + strip.width &&
+           strip_column(area->x2) - strip_column(area->x1) == area->x2 - area->x1;
+}
+
+// An area the scrolled strip splits in panel memory goes out row by row,
+// one window per contiguous run. This is a deliberately synchronous path:
+// every run's polling CASET/RASET waits for the previous run's pixels.
+// It is rare, as the strip owner only invalidates columns that do not
+// wrap and full redraws happen after the strip is stopped.
+static void flush_runs(const lv_area_t *area, uint8_t *px_map)
+{
+    const int edges[3] = {strip.x, strip.x + strip.width - strip.offset, strip.x + strip.width};
+    const int w = lv_area_get_width(area);
+    int bounds[5];
+    int runs = 0;
+
+    bounds[0] = area->x1;
+    for (int i = 0; i < 3; i++) {
+        if (edges[i] > bounds[runs] && edges[i] <= area->x2) {
+            bounds[++runs] = edges[i];
+        }
+    }
+    bounds[++runs] = area->x2 + 1;
+
+    // Counted down by the done callback; set before anything is queued
+    flush.pending = (uint32_t)lv_area_get_height(area) * runs;
+    for (int y = area->y1; y <= area->y2; y++) {
+        for (int r = 0; r < runs; r++) {
+            const int x1 = strip_column(bounds[r]);
+            const int x2 = x1 + bounds[r + 1] - 1 - bounds[r];
+            const uint8_t caset[4] = {x1 >> 8, x1 & 0xff, x2 >> 8, x2 & 0xff};
+            const uint8_t raset[4] = {y >> 8, y & 0xff, y >> 8, y & 0xff};
+            const size_t len = (size_t)(x2 - x1 + 1) * sizeof(uint16_t);
+
+            esp_lcd_panel_io_tx_param(lcd_io, LCD_CMD_CASET, caset, sizeof(caset));
+            esp_lcd_panel_io_tx_param(lcd_io, LCD_CMD_RASET, raset, sizeof(raset));
+            esp_lcd_panel_io_tx_color(lcd_io, LCD_CMD_RAMWR,
+                                      px_map + ((size_t)(y - area->y1) * w + bounds[r] - area->x1) * sizeof(uint16_t),
+                                      len);
+
+            const uint32_t bytes = (1 + 4) * 2 + 1 + len;
+            flush.frame_bytes += bytes;
+            flush.stats.bytes += bytes;
+            flush.stats.transactions += 3;
+        }
+    }
+}
+
+// Send one dirty area: an address window tight around it, then the pixels
+// as a queued DMA transaction. The window goes out as polling tx_param;
+// the previous area is already out by then (see flush_wait_cb), so it
+// does not wait. The overlap is between this area's pixels on the wire
+// and LVGL rendering the next area into the other buffer.
+static void flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+#if ST7789_SW_ROTATE
+    // Reference path for comparison only: rotate each area on the CPU
+    lv_area_t rotated = *area;
+    lv_display_rotation_t rot = lv_display_get_rotation(disp);
+    if (rot != LV_DISPLAY_ROTATION_0) {
+        int32_t w = lv_area_get_width(area);
+        int32_t h = lv_area_get_height(area);
+        int32_t dest_w = rot == LV_DISPLAY_ROTATION_180 ? w : h;
+        lv_draw_sw_rotate(px_map, flush.rotate_buf, w, h,
+                          lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565),
+                          lv_draw_buf_width_to_stride(dest_w, LV_COLOR_FORMAT_RGB565),
+                          rot, LV_COLOR_FORMAT_RGB565);
+        lv_display_rotate_area(disp, &rotated);
+        area = &rotated;
+        px_map = flush.rotate_buf;
+    }
+#endif
+    if (!flush.frame_open) {
+        flush.frame_open = true;
+        flush.frame_start_us = esp_timer_get_time();
+        flush.frame_bytes = 0;
+        flush.frame_areas = 0;
+        if (strip.dirty) {
+            strip_apply();
+        }
+    }
+    flush.frame_areas++;
+    flush.stats.areas++;
+    flush.area_last = lv_display_flush_is_last(disp);
+
+    if (!strip_contiguous(area)) {
+        flush_runs(area, px_map);
+        return;
+    }
+
+    const size_t len = (size_t)lv_area_get_size(area) * sizeof(uint16_t);
+    const int x1 = strip_column(area->x1);
+    const int x2 = x1 + area->x2 - area->x1;
+    const uint8_t caset[4] = {x1 >> 8, x1 & 0xff, x2 >> 8, x2 & 0xff};
+    const uint8_t raset[4] = {area->y1 >> 8, area->y1 & 0xff, area->y2 >> 8, area->y2 & 0xff};
+
+    // Command bytes included: what actually crosses the bus
+    const uint32_t bytes = (1 + 4) * 2 + 1 + len;
+    flush.frame_bytes += bytes;
+    flush.stats.bytes += bytes;
+    flush.stats.transactions += 3;
+
+    esp_lcd_panel_io_tx_param(lcd_io, LCD_CMD_CASET, caset, sizeof(caset));
+    esp_lcd_panel_io_tx_param(lcd_io, LCD_CMD_RASET, raset, sizeof(raset));
+    flush.pending = 1;
+    esp_lcd_panel_io_tx_color(lcd_io, LCD_CMD_RAMWR, px_map, len);
+}
+
+// Rotation is done by the panel's address mode: LVGL renders straight into
+// the rotated resolution, MADCTL maps it onto the glass and flush_cb sends
+// each area as rendered
+static void panel_apply_rotation(int rotation)
+{
+    switch (rotation) {
+        case LV_DISP_ROT_NONE:
+            esp_lcd_panel_swap_xy(lcd_panel, false);
+            esp_lcd_panel_mirror(lcd_panel, false, false);
+            break;
+        case LV_DISP_ROT_90:
+            esp_lcd_panel_swap_xy(lcd_panel, true);
+            esp_lcd_panel_mirror(lcd_panel, true, false);
+            break;
+        case LV_DISP_ROT_180:
+            esp_lcd_panel_swap_xy(lcd_panel, false);
+            esp_lcd_panel_mirror(lcd_panel, true, true);
+            break;
+        case LV_DISP_ROT_270:
+            esp_lcd_panel_swap_xy(lcd_panel, true);
+            esp_lcd_panel_mirror(lcd_panel, false, true);
+            break;
+    }
+}
+
+static bool rotation_is_landscape(int rotation)
+{
+    return rotation == LV_DISP_ROT_90 || rotation == LV_DISP_ROT_270;
+}
 
 void init_lcd(int rotation)
 {
@@ -36,10 +314,11 @@ void init_lcd(int rotation)
         .lcd_cmd_bits = 8,
         .lcd_param_bits = 8,
         .spi_mode = 0,
-        .trans_queue_depth = 10,
+        .trans_queue_depth = LCD_TRANS_QUEUE,
     };
     ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)LCD_HOST,
                                              &io_config, &io_handle));
+    lcd_io = io_handle;
 
     ESP_LOGI(TAG, "Install ST7789 panel driver");
     static esp_lcd_panel_handle_t panel_handle = NULL;
@@ -49,6 +328,7 @@ void init_lcd(int rotation)
         .bits_per_pixel = 16,
     };
     ESP_ERROR_CHECK(esp_lcd_new_panel_st7789(io_handle, &panel_config, &panel_handle));
+    lcd_panel = panel_handle;
 
     ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
     ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
@@ -66,62 +346,205 @@ void init_lcd(int rotation)
     gpio_set_level(PIN_NUM_BK_LIGHT, LCD_BK_LIGHT_ON);
 
     ESP_LOGI(TAG, "Initialize LVGL");
-    const lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    ESP_ERROR_CHECK(lvgl_port_init(&lvgl_cfg));
-
-    const lvgl_port_display_cfg_t disp_cfg = {
-        .io_handle = io_handle,
-        .panel_handle = panel_handle,
-        .buffer_size = LCD_H_RES * LVGL_BUFFER_HEIGHT * sizeof(uint16_t),
-        .double_buffer = true,
-        .hres = LCD_H_RES,
-        .vres = LCD_V_RES,
-        .monochrome = false,
-        .rotation = {
-            .swap_xy = false,
-            .mirror_x = false,
-            .mirror_y = false,
-        },
-        .flags = {
-            .buff_dma = true,
-        }
-    };
-    lvgl_disp = lvgl_port_add_disp(&disp_cfg);
+    const lvgl_sched_cfg_t lvgl_cfg = LVGL_SCHED_DEFAULT_CONFIG();
+    ESP_ERROR_CHECK(lvgl_sched_init(&lvgl_cfg));
+
+    const size_t buffer_size = LCD_H_RES * LVGL_BUFFER_HEIGHT * sizeof(uint16_t);
+    void *buf1 = heap_caps_malloc(buffer_size, MALLOC_CAP_DMA);
+    void *buf2 = heap_caps_malloc(buffer_size, MALLOC_CAP_DMA);
+    if (!buf1 || !buf2) {
+        ESP_LOGE(TAG, "Not enough DMA memory for display buffers");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+    // First area queued to last pixel out, per frame
+    flush.frame_hist = perf_hist_register("flush");
+    flush.done = xSemaphoreCreateBinary();
+    if (!flush.done) {
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
 
-    // Rotate display to portrait mode if needed
-    lv_disp_set_rotation(lvgl_disp, rotation); // 0 - no rotation
+#if ST7789_SW_ROTATE
+    flush.rotate_buf = heap_caps_malloc(buffer_size, MALLOC_CAP_DMA);
+    if (!flush.rotate_buf) {
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+#endif
+
+    lvgl_sched_lock(0);
+#if ST7789_SW_ROTATE
+    // Native resolution, LVGL rotates every flushed area
+    lvgl_disp = lv_display_create(LCD_H_RES, LCD_V_RES);
+    lv_display_set_rotation(lvgl_disp, rotation);
+    panel_apply_rotation(LV_DISP_ROT_NONE);
+#else
+    // Render directly at the rotated resolution
+    lcd_rotation = rotation;
+    panel_apply_rotation(rotation);
+    lvgl_disp = rotation_is_landscape(rotation) ? lv_display_create(LCD_V_RES, LCD_H_RES)
+                                                : lv_display_create(LCD_H_RES, LCD_V_RES);
+#endif
+    lv_display_set_color_format(lvgl_disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(lvgl_disp, buf1, buf2, buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(lvgl_disp, flush_cb);
+    lv_display_set_flush_wait_cb(lvgl_disp, flush_wait_cb);
+
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = flush_tx_done,
+    };
+    ESP_ERROR_CHECK(esp_lcd_panel_io_register_event_callbacks(io_handle, &cbs, lvgl_disp));
+    lvgl_sched_attach_display(lvgl_disp);
+    lvgl_sched_unlock();
 
 
     ESP_LOGI(TAG, "Setup complete");
 }
 
+void st7789_set_rotation(int rotation)
+{
+    if (rotation == lcd_rotation) {
+        return;
+    }
+    lcd_rotation = rotation;
+    panel_apply_rotation(rotation);
+    st7789_strip_stop();
+    // A new resolution invalidates the whole screen; LVGL lays out again
+    if (rotation_is_landscape(rotation)) {
+        lv_display_set_resolution(lvgl_disp, LCD_V_RES, LCD_H_RES);
+    } else {
+        lv_display_set_resolution(lvgl_disp, LCD_H_RES, LCD_V_RES);
+    }
+}
+
+// SLPOUT has settled: redraw everything, then light the backlight over the
+// current frame
+static void wake_timer_cb(lv_timer_t *timer)
+{
+    wake_timer = NULL;
+    lcd_powered = true;
+    lv_display_enable_invalidation(lvgl_disp, true);
+    lv_obj_invalidate(lv_display_get_screen_active(lvgl_disp));
+    lv_refr_now(lvgl_disp);
+    gpio_set_level(PIN_NUM_BK_LIGHT, LCD_BK_LIGHT_ON);
+}
+
+void st7789_set_power(bool on)
+{
+    if (!lvgl_sched_lock(0)) {
+        return;
+    }
+    if (on && !lcd_powered && wake_timer == NULL) {
+        // The glass still shows the old frame; the backlight waits for the
+        // redraw, which waits out the 120 ms SLPOUT delay in an LVGL timer
+        // instead of blocking the caller
+        esp_lcd_panel_disp_sleep(lcd_panel, false);
+        wake_timer = lv_timer_create(wake_timer_cb, LCD_SLPOUT_DELAY_MS, NULL);
+        lv_timer_set_repeat_count(wake_timer, 1);
+    } else if (!on && (lcd_powered || wake_timer != NULL)) {
+        // No invalidation means no render passes and no SPI traffic until
+        // the panel is back; widgets still take updates
+        if (wake_timer != NULL) {
+            lv_timer_delete(wake_timer);
+            wake_timer = NULL;
+        }
+        lcd_powered = false;
+        gpio_set_level(PIN_NUM_BK_LIGHT, LCD_BK_LIGHT_OFF);
+        lv_display_enable_invalidation(lvgl_disp, false);
+        esp_lcd_panel_disp_sleep(lcd_panel, true);
+    }
+    lvgl_sched_unlock();
+}
+
+esp_err_t st7789_strip_scroll(int x, int width, int columns)
+{
+#if ST7789_SW_ROTATE
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (lcd_rotation != LV_DISP_ROT_90 && lcd_rotation != LV_DISP_ROT_270) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (x < 0 || width <= 0 || x + width > LCD_V_RES || columns <= 0 || columns >= width) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!lcd_powered) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!strip.active || strip.x != x || strip.width != width) {
+        // The glass matches memory until the first scroll
+        st7789_strip_stop();
+        strip.active = true;
+        strip.x = x;
+        strip.width = width;
+        strip.offset = 0;
+    }
+    strip.offset = (strip.offset + columns) % width;
+    strip.dirty = true;
+    return ESP_OK;
+#endif
+}
+
+void st7789_strip_stop(void)
+{
+    if (!strip.active) {
+        return;
+    }
+    // Unscrolled, the band's memory no longer lines up with the glass
+    if (strip.offset != 0) {
+        const lv_area_t band = {
+            .x1 = strip.x,
+            .y1 = 0,
+            .x2 = strip.x + strip.width - 1,
+            .y2 = lv_display_get_vertical_resolution(lvgl_disp) - 1,
+        };
+        lv_obj_invalidate_area(lv_display_get_screen_active(lvgl_disp), &band);
+    }
+    strip.active = false;
+    strip.offset = 0;
+    strip.dirty = true;
+}
+
+void st7789_get_flush_stats(st7789_flush_stats_t *stats)
+{
+    *stats = flush.stats;
+    // Bytes per microsecond is MB/s; keep two decimals. Worked out here,
+    // not in the ISR, to keep 64-bit division out of IRAM.
+    stats->last_frame_mbps_x100 = stats->last_frame_us
+        ? (uint32_t)((uint64_t)stats->last_frame_bytes * 100 / stats->last_frame_us) : 0;
+}
+
 void create_background(void)
 {
-    if (lvgl_port_lock(0)) {
+    if (lvgl_sched_lock(0)) {
 
         lv_obj_t *screen = lv_screen_active();
         lv_obj_set_style_bg_color(screen, lv_color_make(0, 0, 0), LV_PART_MAIN);
         lv_obj_set_style_bg_opa(screen, LV_OPA_COVER, LV_PART_MAIN);
 
-        lvgl_port_unlock();
+        lvgl_sched_unlock();
     }
 }
 
 
-void create_label(const lv_font_t *font, int x, int y, char *text)
+// Opacity is one style shared by every label; font and colour are the
+// caller's and set per label
+void create_label(const lv_font_t *font, lv_color_t color, int x, int y, char *text)
 {
-    if (lvgl_port_lock(0)) {
+    static lv_style_t style;
+    static bool style_ready = false;
+
+    if (lvgl_sched_lock(0)) {
+        if (!style_ready) {
+            lv_style_init(&style);
+            lv_style_set_text_opa(&style, LV_OPA_COVER);
+            style_ready = true;
+        }
 
         lv_obj_t *label = lv_label_create(lv_screen_active());
         lv_label_set_text(label, text);
-
+        lv_obj_add_style(label, &style, 0);
         lv_obj_set_style_text_font(label, font, 0);
-
-        lv_obj_set_style_text_color(label, lv_color_make(31, 31, 63), 0);
-        lv_obj_set_style_text_opa(label, LV_OPA_COVER, 0);
- 
+        lv_obj_set_style_text_color(label, color, 0);
         lv_obj_set_pos(label, x, y);
 
-        lvgl_port_unlock();
+        lvgl_sched_unlock();
     }
 }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+// Scrolling strip chart: a line plot with a 50% area fill where each new
+// value enters at the right edge and everything moves left by a fixed
+// number of columns. Drawing is shift invariant (horizontal grid, vertical
+// grid lines tied to sample numbers, no left or right border), so after a
+// push the old picture is the new one moved left. With a hardware scroll
+// hook the panel does that move and the chart invalidates the exposed
+// columns; without one it invalidates itself whole.
+//
+// The widget sets its own width to points * step; the caller sets its
+// position and height. Vertical padding is the plot margin. Everything
+// runs in the LVGL task.
+
+typedef struct {
+    uint16_t points;            // values visible at once
+    uint16_t step;              // columns per value
+    int32_t min, max;           // value range, bottom to top
+    uint8_t h_div;              // horizontal grid lines, top and bottom included
+    uint16_t v_div_every;       // vertical grid line every N values, 0 for none
+    uint8_t line_width;
+    lv_color_t line_color;
+    lv_color_t grid_color;
+    lv_opa_t fill_opa;          // area under the line, in line_color
+} strip_chart_cfg_t;
+
+// Moves `band` (absolute coordinates, full display height) left by
+// `columns` on the glass; returns false if it cannot, e.g. the display
+// is off or in portrait
+typedef bool (*strip_chart_scroll_fn_t)(const lv_area_t *band, int32_t columns);
+
+// One hook for all strip charts, e.g. a panel driver's scroll
+void strip_chart_set_hw_scroll(strip_chart_scroll_fn_t scroll);
+
+lv_obj_t *strip_chart_create(lv_obj_t *parent, const strip_chart_cfg_t *cfg);
+uint32_t strip_chart_get_point_count(const lv_obj_t *obj);
+
+// Append one value at the right edge
+void strip_chart_push(lv_obj_t *obj, int32_t value);
+
+// Replace all values, oldest first; redraws the whole chart
+void strip_chart_set_points(lv_obj_t *obj, const int32_t *values, uint32_t count);
+
+// Draw from a ring of `size` values owned by the caller instead of the
+// chart's own copy; push and set_points no longer apply. The caller
+// writes the ring and reports its state with strip_chart_ext_sync().
+void strip_chart_set_ext_values(lv_obj_t *obj, const int32_t *values, uint32_t size);
+
+// The external ring's next write goes to slot `head` and `count` slots
+// are filled. One new value scrolls the chart, anything else redraws it.
+void strip_chart_ext_sync(lv_obj_t *obj, uint32_t head, uint32_t count);
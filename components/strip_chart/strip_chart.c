@@ -0,0 +1,259 @@
+#include <string.h>
+#include "strip_chart.h"
+
+typedef struct {
+    strip_chart_cfg_t cfg;
+    const int32_t *values;      // `own`, or the caller's ring
+    uint32_t capacity;          // own: points + 1, the segment leaving on the left
+    uint32_t count;
+    uint32_t head;              // slot of the next value
+    uint32_t total;             // values pushed, numbers the vertical grid
+    int32_t own[];
+} strip_chart_t;
+
+static strip_chart_scroll_fn_t s_scroll = NULL;
+
+void strip_chart_set_hw_scroll(strip_chart_scroll_fn_t scroll)
+{
+    s_scroll = scroll;
+}
+
+// Value `age` samples back from the newest, age < count
+static int32_t value_at(const strip_chart_t *sc, uint32_t age)
+{
+    return sc->values[(sc->head + sc->capacity - 1 - age) % sc->capacity];
+}
+
+static int32_t value_y(const strip_chart_t *sc, int32_t value, int32_t top, int32_t bottom)
+{
+    if (value <= sc->cfg.min) {
+        return bottom;
+    }
+    if (value >= sc->cfg.max) {
+        return top;
+    }
+    return bottom - (int32_t)((int64_t)(value - sc->cfg.min) * (bottom - top) / (sc->cfg.max - sc->cfg.min));
+}
+
+// Everything is placed relative to the right edge and sample numbers, so a
+// push moves the whole picture left by exactly `step` columns. Only what
+// intersects the area being redrawn is drawn.
+static void draw_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_current_target_obj(e);
+    const strip_chart_t *sc = lv_obj_get_user_data(obj);
+    lv_layer_t *layer = lv_event_get_layer(e);
+    const lv_area_t *clip = &layer->_clip_area;
+    const int32_t step = sc->cfg.step;
+    lv_area_t coords;
+    lv_area_t plot;
+
+    lv_obj_get_coords(obj, &coords);
+    lv_obj_get_content_coords(obj, &plot);
+
+    lv_draw_line_dsc_t grid;
+    lv_draw_line_dsc_init(&grid);
+    grid.color = sc->cfg.grid_color;
+    grid.width = 1;
+
+    for (int i = 0; i < sc->cfg.h_div; i++) {
+        const int32_t y = sc->cfg.h_div > 1 ? plot.y1 + i * (plot.y2 - plot.y1) / (sc->cfg.h_div - 1) : plot.y2;
+        if (y < clip->y1 || y > clip->y2) {
+            continue;
+        }
+        grid.p1.x = coords.x1;
+        grid.p1.y = y;
+        grid.p2.x = coords.x2;
+        grid.p2.y = y;
+        lv_draw_line(layer, &grid);
+    }
+
+    lv_draw_rect_dsc_t fill;
+    lv_draw_rect_dsc_init(&fill);
+    fill.bg_color = sc->cfg.line_color;
+    fill.bg_opa = sc->cfg.fill_opa;
+
+    lv_draw_line_dsc_t line;
+    lv_draw_line_dsc_init(&line);
+    line.color = sc->cfg.line_color;
+    line.width = sc->cfg.line_width;
+    line.round_start = 1;
+    line.round_end = 1;
+
+    const int32_t reach = sc->cfg.line_width;
+
+    for (uint32_t age = 0; age < sc->count; age++) {
+        const int32_t x = coords.x2 - (int32_t)age * step;
+        if (x - step > clip->x2 + reach) {
+            continue;
+        }
+        if (x + reach < clip->x1) {
+            break;
+        }
+
+        if (sc->cfg.v_div_every && (sc->total - 1 - age) % sc->cfg.v_div_every == 0 && x >= clip->x1 &&
+            x <= clip->x2) {
+            grid.p1.x = x;
+            grid.p1.y = plot.y1;
+            grid.p2.x = x;
+            grid.p2.y = plot.y2;
+            lv_draw_line(layer, &grid);
+        }
+        if (age + 1 >= sc->count) {
+            break;
+        }
+
+        // Segment to the previous value: the fill one column at a time,
+        // covering (x - step, x], then the line over it
+        const int32_t y_new = value_y(sc, value_at(sc, age), plot.y1, plot.y2);
+        const int32_t y_old = value_y(sc, value_at(sc, age + 1), plot.y1, plot.y2);
+
+        if (sc->cfg.fill_opa > LV_OPA_MIN) {
+            const int32_t from = LV_MAX(x - step + 1, clip->x1);
+            const int32_t to = LV_MIN(x, clip->x2);
+            for (int32_t col = from; col <= to; col++) {
+                const lv_area_t strip = {
+                    .x1 = col,
+                    .y1 = y_old + (y_new - y_old) * (col - (x - step)) / step,
+                    .x2 = col,
+                    .y2 = plot.y2,
+                };
+                lv_draw_rect(layer, &fill, &strip);
+            }
+        }
+
+        line.p1.x = x - step;
+        line.p1.y = y_old;
+        line.p2.x = x;
+        line.p2.y = y_new;
+        lv_draw_line(layer, &line);
+    }
+}
+
+static void delete_cb(lv_event_t *e)
+{
+    lv_obj_t *obj = lv_event_get_current_target_obj(e);
+
+    lv_free(lv_obj_get_user_data(obj));
+    lv_obj_set_user_data(obj, NULL);
+}
+
+lv_obj_t *strip_chart_create(lv_obj_t *parent, const strip_chart_cfg_t *cfg)
+{
+    const uint32_t capacity = cfg->points + 1;
+    strip_chart_t *sc = lv_malloc_zeroed(sizeof(*sc) + capacity * sizeof(int32_t));
+
+    if (sc == NULL) {
+        return NULL;
+    }
+    sc->cfg = *cfg;
+    sc->values = sc->own;
+    sc->capacity = capacity;
+
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_remove_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_width(obj, cfg->points * cfg->step);
+    lv_obj_set_user_data(obj, sc);
+    lv_obj_add_event_cb(obj, draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(obj, delete_cb, LV_EVENT_DELETE, NULL);
+    return obj;
+}
+
+uint32_t strip_chart_get_point_count(const lv_obj_t *obj)
+{
+    const strip_chart_t *sc = lv_obj_get_user_data(obj);
+
+    return sc->cfg.points;
+}
+
+// The hardware can only move what is on the glass, and everything in the
+// band's columns moves, so the chart has to span the display's height
+static bool can_scroll(lv_obj_t *obj, const lv_area_t *band)
+{
+    lv_display_t *disp = lv_obj_get_display(obj);
+
+    return s_scroll != NULL && lv_obj_get_screen(obj) == lv_display_get_screen_active(disp) &&
+           !lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) && band->x1 >= 0 && band->y1 <= 0 &&
+           band->x2 < lv_display_get_horizontal_resolution(disp) &&
+           band->y2 >= lv_display_get_vertical_resolution(disp) - 1;
+}
+
+// A value entered on the right: scroll what is on the glass if possible
+static void shift_in(lv_obj_t *obj, const strip_chart_t *sc)
+{
+    lv_area_t band;
+
+    // The new segment's left end is the previous value's round cap, which
+    // is already on the glass, so the exposed columns are all that changes
+    lv_obj_get_coords(obj, &band);
+    if (can_scroll(obj, &band) && s_scroll(&band, sc->cfg.step)) {
+        band.x1 = band.x2 - sc->cfg.step + 1;
+        lv_obj_invalidate_area(obj, &band);
+    } else {
+        lv_obj_invalidate(obj);
+    }
+}
+
+void strip_chart_push(lv_obj_t *obj, int32_t value)
+{
+    strip_chart_t *sc = lv_obj_get_user_data(obj);
+
+    sc->own[sc->head] = value;
+    sc->head = (sc->head + 1) % sc->capacity;
+    if (sc->count < sc->capacity) {
+        sc->count++;
+    }
+    sc->total++;
+    shift_in(obj, sc);
+}
+
+void strip_chart_set_points(lv_obj_t *obj, const int32_t *values, uint32_t count)
+{
+    strip_chart_t *sc = lv_obj_get_user_data(obj);
+    const uint32_t keep = count < sc->capacity ? count : sc->capacity;
+
+    memcpy(sc->own, values + count - keep, keep * sizeof(int32_t));
+    sc->count = keep;
+    sc->head = keep % sc->capacity;
+    sc->total = count;
+    lv_obj_invalidate(obj);
+}
+
+void strip_chart_set_ext_values(lv_obj_t *obj, const int32_t *values, uint32_t size)
+{
+    strip_chart_t *sc = lv_obj_get_user_data(obj);
+
+    // The chart's own copy is not needed any more
+    strip_chart_t *shrunk = lv_realloc(sc, sizeof(*sc));
+    if (shrunk != NULL) {
+        sc = shrunk;
+        lv_obj_set_user_data(obj, sc);
+    }
+    sc->values = values;
+    sc->capacity = size;
+    sc->head = 0;
+    sc->count = 0;
+    sc->total = 0;
+    lv_obj_invalidate(obj);
+}
+
+void strip_chart_ext_sync(lv_obj_t *obj, uint32_t head, uint32_t count)
+{
+    strip_chart_t *sc = lv_obj_get_user_data(obj);
+    const uint32_t added = (head + sc->capacity - sc->head) % sc->capacity;
+
+    if (added == 0 && count == sc->count) {
+        return;
+    }
+    sc->head = head;
+    sc->count = count;
+    if (added == 1 && sc->total > 0) {
+        sc->total++;
+        shift_in(obj, sc);
+    } else {
+        // Grid numbering restarts; it only has to stay fixed to the samples
+        sc->total = count;
+        lv_obj_invalidate(obj);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+// Bounded queue of UI mutations. Tasks outside LVGL post small typed
+// commands without blocking and never take the LVGL lock; the LVGL side
+// drains the queue when woken and applies the whole batch in one go.
+// Draining coalesces: any number of sample notifications become one
+// update, screen steps are summed into one screen load, and toggles only
+// count modulo two.
+
+typedef enum {
+    UI_CMD_SAMPLE,          // a new sensor snapshot has been published
+    UI_CMD_NEXT_SCREEN,     // advance by `arg` screens
+    UI_CMD_SCREEN_POWER,    // toggle the screen on or off
+    UI_CMD_ROTATE,          // flip the screen by 180 degrees
+} ui_cmd_type_t;
+
+typedef struct {
+    uint8_t type;           // ui_cmd_type_t
+    int8_t arg;
+} ui_cmd_t;
+
+typedef struct {
+    uint32_t samples;       // sample notifications folded into this batch
+    int32_t screen_steps;
+    uint32_t power_toggles;
+    uint32_t rotations;
+} ui_batch_t;
+
+typedef struct {
+    uint32_t posted;
+    uint32_t dropped;       // queue full
+    uint32_t batches;       // non-empty drains
+    uint32_t coalesced;     // commands merged into an earlier one of a batch
+} ui_queue_stats_t;
+
+esp_err_t ui_queue_init(uint32_t depth);
+
+// Called after every successful post so the consumer can sleep until
+// there is something to drain
+void ui_queue_set_wake(void (*wake)(void), void (*wake_from_isr)(BaseType_t *higher_prio_woken));
+
+// Non-blocking; false if the queue was full and the command was dropped
+bool ui_queue_post(ui_cmd_type_t type, int8_t arg);
+bool ui_queue_post_from_isr(ui_cmd_type_t type, int8_t arg, BaseType_t *higher_prio_woken);
+
+// LVGL context only. Collects everything queued so far into `batch`;
+// returns false if the queue was empty.
+bool ui_queue_drain(ui_batch_t *batch);
+
+void ui_queue_get_stats(ui_queue_stats_t *stats);
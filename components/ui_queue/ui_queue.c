@@ -0,0 +1,118 @@
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "ui_queue.h"
+
+static const char *TAG = "UI_QUEUE";
+
+static QueueHandle_t s_queue = NULL;
+static ui_queue_stats_t s_stats;         // batches and coalesced, drain side only
+// Posts come from tasks and ISRs alike
+static atomic_uint s_posted;
+static atomic_uint s_dropped;
+static void (*s_wake)(void) = NULL;
+static void (*s_wake_from_isr)(BaseType_t *higher_prio_woken) = NULL;
+
+esp_err_t ui_queue_init(uint32_t depth)
+{
+    s_queue = xQueueCreate(depth, sizeof(ui_cmd_t));
+    if (!s_queue) {
+        ESP_LOGE(TAG, "Failed to create queue");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ui_queue_set_wake(void (*wake)(void), void (*wake_from_isr)(BaseType_t *higher_prio_woken))
+{
+    s_wake = wake;
+    s_wake_from_isr = wake_from_isr;
+}
+
+bool ui_queue_post(ui_cmd_type_t type, int8_t arg)
+{
+    const ui_cmd_t cmd = {
+        .type = type,
+        .arg = arg,
+    };
+
+    if (xQueueSend(s_queue, &cmd, 0) != pdTRUE) {
+        atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    atomic_fetch_add_explicit(&s_posted, 1, memory_order_relaxed);
+    if (s_wake) {
+        s_wake();
+    }
+    return true;
+}
+
+bool ui_queue_post_from_isr(ui_cmd_type_t type, int8_t arg, BaseType_t *higher_prio_woken)
+{
+    const ui_cmd_t cmd = {
+        .type = type,
+        .arg = arg,
+    };
+
+    if (xQueueSendFromISR(s_queue, &cmd, higher_prio_woken) != pdTRUE) {
+        atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    atomic_fetch_add_explicit(&s_posted, 1, memory_order_relaxed);
+    if (s_wake_from_isr) {
+        s_wake_from_isr(higher_prio_woken);
+    }
+    return true;
+}
+
+bool ui_queue_drain(ui_batch_t *batch)
+{
+    ui_cmd_t cmd;
+    uint32_t received = 0;
+    uint32_t kinds = 0;
+
+    batch->samples = 0;
+    batch->screen_steps = 0;
+    batch->power_toggles = 0;
+    batch->rotations = 0;
+
+    while (xQueueReceive(s_queue, &cmd, 0) == pdTRUE) {
+        received++;
+        switch (cmd.type) {
+            case UI_CMD_SAMPLE:
+                kinds += batch->samples == 0;
+                batch->samples++;
+                break;
+            case UI_CMD_NEXT_SCREEN:
+                kinds += batch->screen_steps == 0;
+                batch->screen_steps += cmd.arg;
+                break;
+            case UI_CMD_SCREEN_POWER:
+                kinds += batch->power_toggles == 0;
+                batch->power_toggles++;
+                break;
+            case UI_CMD_ROTATE:
+                kinds += batch->rotations == 0;
+                batch->rotations++;
+                break;
+            default:
+                ESP_LOGW(TAG, "Unknown command %u", cmd.type);
+                break;
+        }
+    }
+
+    if (received == 0) {
+        return false;
+    }
+    s_stats.batches++;
+    s_stats.coalesced += received - kinds;
+    return true;
+}
+
+void ui_queue_get_stats(ui_queue_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->posted = atomic_load_explicit(&s_posted, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+}
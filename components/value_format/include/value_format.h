@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Integer-only text for the readings: "<prefix><value> <unit>", e.g.
+// ": 23.4 C" or " 812 ppm". No printf, no floating point and no locale,
+// so a label update costs a few dozen cycles instead of a vfprintf call.
+
+// Longest text for the prefixes and units the UI uses, NUL included
+#define VALUE_FORMAT_MAX 24
+
+// `value` in tenths is shown with one decimal. Returns the length, or 0
+// with an empty `buf` if the text does not fit in `size` bytes.
+size_t value_format(char *buf, size_t size, const char *prefix, int32_t value, bool tenths,
+                    const char *unit);
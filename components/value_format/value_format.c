@@ -0,0 +1,42 @@
+#include <string.h>
+#include "value_format.h"
+
+size_t value_format(char *buf, size_t size, const char *prefix, int32_t value, bool tenths,
+                    const char *unit)
+{
+    char digits[12];    // reversed: 10 digits and a decimal point
+    int n = 0;
+    uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+
+    do {
+        digits[n++] = (char)('0' + mag % 10);
+        mag /= 10;
+        if (tenths && n == 1) {
+            digits[n++] = '.';
+        }
+    } while (mag > 0 || (tenths && n < 3));
+
+    const size_t prefix_len = strlen(prefix);
+    const size_t unit_len = strlen(unit);
+    const size_t len = prefix_len + (value < 0) + n + 1 + unit_len;
+
+    if (len >= size) {
+        if (size > 0) {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+
+    char *p = buf;
+    memcpy(p, prefix, prefix_len);
+    p += prefix_len;
+    if (value < 0) {
+        *p++ = '-';
+    }
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    *p++ = ' ';
+    memcpy(p, unit, unit_len + 1);
+    return len;
+}
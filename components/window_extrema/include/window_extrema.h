@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Sliding-window minimum and maximum over the last N samples of each
+// channel. Every channel keeps a monotonic deque of sample sequence numbers
+// over a shared ring of values, so a push costs amortised O(1) regardless of
+// the window length and a query is O(1).
+//
+// Memory is 48 bytes per window slot (3 low and 3 high values + 6 deque
+// entries): a 1 hour window at the 5 s sample rate is ~34 KB. For long
+// windows push a coarser stream instead, e.g. the min/max buckets of a
+// sample_store tier through window_extrema_push_range(): a day of 15-min
+// buckets is 96 slots.
+
+typedef enum {
+    WEXT_CH_TEMP,   // centi-degrees C
+    WEXT_CH_HUM,    // centi-percent RH
+    WEXT_CH_CO2,    // ppm
+    WEXT_CHANNELS
+} wext_channel_t;
+
+typedef struct {
+    uint32_t head;      // slot of the oldest entry
+    uint32_t count;
+    uint32_t *seq;      // window_len slots
+} wext_deque_t;
+
+typedef struct {
+    uint32_t window_len;
+    uint32_t next_seq;  // number of samples pushed so far
+    int32_t *ring;      // window_len slots of WEXT_CHANNELS low, then high values
+    wext_deque_t min_q[WEXT_CHANNELS];
+    wext_deque_t max_q[WEXT_CHANNELS];
+} window_extrema_t;
+
+esp_err_t window_extrema_init(window_extrema_t *w, uint32_t window_len);
+void window_extrema_deinit(window_extrema_t *w);
+void window_extrema_reset(window_extrema_t *w);
+
+void window_extrema_push(window_extrema_t *w, const int32_t values[WEXT_CHANNELS]);
+
+// One entry that spans a range per channel, e.g. a bucket of samples: the
+// minimum is taken over `lo` and the maximum over `hi`
+void window_extrema_push_range(window_extrema_t *w, const int32_t lo[WEXT_CHANNELS],
+                               const int32_t hi[WEXT_CHANNELS]);
+
+// Number of samples currently inside the window
+uint32_t window_extrema_count(const window_extrema_t *w);
+
+// Returns false while the window is still empty
+bool window_extrema_get(const window_extrema_t *w, wext_channel_t ch, int32_t *min, int32_t *max);
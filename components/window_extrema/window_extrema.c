@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include "window_extrema.h"
+
+#define RING_SLOT_VALUES (2 * WEXT_CHANNELS)
+
+// Low value of a channel for the min deque, high value for the max deque
+static inline int32_t ring_value(const window_extrema_t *w, uint32_t seq, int ch, bool less)
+{
+    return w->ring[(seq % w->window_len) * RING_SLOT_VALUES + (less ? 0 : WEXT_CHANNELS) + ch];
+}
+
+static inline uint32_t dq_slot(const window_extrema_t *w, const wext_deque_t *q, uint32_t i)
+{
+    return (q->head + i) % w->window_len;
+}
+
+static inline uint32_t dq_front(const wext_deque_t *q)
+{
+    return q->seq[q->head];
+}
+
+static inline uint32_t dq_back(const window_extrema_t *w, const wext_deque_t *q)
+{
+    return q->seq[dq_slot(w, q, q->count - 1)];
+}
+
+// Expire entries that left the window, drop entries that can no longer be
+// the extreme, then append the new sample. `less` selects min (true) or max
+// (false) ordering.
+static void dq_push(window_extrema_t *w, wext_deque_t *q, int ch, uint32_t seq, int32_t value, bool less)
+{
+    while (q->count > 0 && seq - dq_front(q) >= w->window_len) {
+        q->head = (q->head + 1) % w->window_len;
+        q->count--;
+    }
+
+    while (q->count > 0) {
+        int32_t back = ring_value(w, dq_back(w, q), ch, less);
+        if (less ? back < value : back > value) {
+            break;
+        }
+        q->count--;
+    }
+
+    q->seq[dq_slot(w, q, q->count)] = seq;
+    q->count++;
+}
+
+esp_err_t window_extrema_init(window_extrema_t *w, uint32_t window_len)
+{
+    if (!w || window_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(w, 0, sizeof(*w));
+    size_t ring_size = (size_t)window_len * RING_SLOT_VALUES;
+    size_t dq_size = (size_t)window_len * 2 * WEXT_CHANNELS;
+
+    // Value ring, and one allocation shared by the six deques
+    int32_t *ring = calloc(ring_size, sizeof(int32_t));
+    uint32_t *seq = calloc(dq_size, sizeof(uint32_t));
+    if (!ring || !seq) {
+        free(ring);
+        free(seq);
+        return ESP_ERR_NO_MEM;
+    }
+
+    w->window_len = window_len;
+    w->ring = ring;
+    for (int ch = 0; ch < WEXT_CHANNELS; ch++) {
+        w->min_q[ch].seq = seq + (size_t)(2 * ch) * window_len;
+        w->max_q[ch].seq = seq + (size_t)(2 * ch + 1) * window_len;
+    }
+    return ESP_OK;
+}
+
+void window_extrema_deinit(window_extrema_t *w)
+{
+    if (!w) {
+        return;
+    }
+    free(w->ring);
+    free(w->min_q[0].seq);
+    memset(w, 0, sizeof(*w));
+}
+
+void window_extrema_reset(window_extrema_t *w)
+{
+    w->next_seq = 0;
+    for (int ch = 0; ch < WEXT_CHANNELS; ch++) {
+        w->min_q[ch].head = w->min_q[ch].count = 0;
+        w->max_q[ch].head = w->max_q[ch].count = 0;
+    }
+}
+
+void window_extrema_push_range(window_extrema_t *w, const int32_t lo[WEXT_CHANNELS],
+                               const int32_t hi[WEXT_CHANNELS])
+{
+    uint32_t seq = w->next_seq++;
+    int32_t *slot = &w->ring[(seq % w->window_len) * RING_SLOT_VALUES];
+    memcpy(slot, lo, WEXT_CHANNELS * sizeof(int32_t));
+    memcpy(slot + WEXT_CHANNELS, hi, WEXT_CHANNELS * sizeof(int32_t));
+
+    for (int ch = 0; ch < WEXT_CHANNELS; ch++) {
+        dq_push(w, &w->min_q[ch], ch, seq, lo[ch], true);
+        dq_push(w, &w->max_q[ch], ch, seq, hi[ch], false);
+    }
+}
+
+void window_extrema_push(window_extrema_t *w, const int32_t values[WEXT_CHANNELS])
+{
+    window_extrema_push_range(w, values, values);
+}
+
+uint32_t window_extrema_count(const window_extrema_t *w)
+{
+    return w->next_seq < w->window_len ? w->next_seq : w->window_len;
+}
+
+bool window_extrema_get(const window_extrema_t *w, wext_channel_t ch, int32_t *min, int32_t *max)
+{
+    if (ch >= WEXT_CHANNELS || w->next_seq == 0) {
+        return false;
+    }
+    if (min) {
+        *min = ring_value(w, dq_front(&w->min_q[ch]), ch, true);
+    }
+    if (max) {
+        *max = ring_value(w, dq_front(&w->max_q[ch]), ch, false);
+    }
+    return true;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+// Host wall time scaled to the target CPU (sim_rtos.c), so cycle spans
+// convert to the same estimated target time as the run time stats
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
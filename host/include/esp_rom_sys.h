@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+#define SIM_CPU_MHZ 160
+
+static inline uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return SIM_CPU_MHZ;
+}
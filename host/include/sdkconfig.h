@@ -0,0 +1,6 @@
+// Host stand-in for the generated sdkconfig.h: only the options the
+// firmware tests for. Power management is a target feature and stays off.
+#pragma once
+
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 1
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY 1
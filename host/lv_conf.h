@@ -0,0 +1,50 @@
+// LVGL configuration for the host build. Mirrors the CONFIG_LV_* values in
+// sdkconfig so that heap use and rendering match the target; anything not
+// listed here takes the lv_conf_internal.h default.
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH              16
+
+#define LV_USE_STDLIB_MALLOC        LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_STRING        LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_SPRINTF       LV_STDLIB_BUILTIN
+#define LV_MEM_SIZE                 (64 * 1024U)
+#define LV_MEM_POOL_EXPAND_SIZE     0
+
+#define LV_DEF_REFR_PERIOD          33
+#define LV_DPI_DEF                  130
+
+#define LV_USE_OS                   LV_OS_NONE
+
+#define LV_DRAW_BUF_STRIDE_ALIGN    1
+#define LV_DRAW_BUF_ALIGN           4
+#define LV_DRAW_LAYER_SIMPLE_BUF_SIZE (24 * 1024)
+#define LV_USE_DRAW_SW              1
+#define LV_DRAW_SW_COMPLEX          1
+
+#define LV_USE_ASSERT_NULL          1
+#define LV_USE_ASSERT_MALLOC        1
+
+#define LV_CACHE_DEF_SIZE           0
+#define LV_IMAGE_HEADER_CACHE_DEF_CNT 0
+
+#define LV_FONT_MONTSERRAT_10       1
+#define LV_FONT_MONTSERRAT_14       1
+#define LV_FONT_DEFAULT             &lv_font_montserrat_14
+#define LV_USE_FONT_PLACEHOLDER     1
+// Set to 1 by CMake when FONT_COMPRESS subset fonts are built
+#ifndef LV_USE_FONT_COMPRESSED
+#define LV_USE_FONT_COMPRESSED      0
+#endif
+
+#define LV_TXT_ENC                  LV_TXT_ENC_UTF8
+
+#define LV_USE_LOG                  0
+
+#define LV_USE_OBSERVER             1
+
+#define LV_BUILD_EXAMPLES           0
+#define LV_BUILD_DEMOS              0
+
+#endif /*LV_CONF_H*/
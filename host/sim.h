@@ -0,0 +1,85 @@
+// Internal interface of the host simulation: virtual clock, scripted inputs
+// and the metrics reported at the end of a run.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_GPIO_COUNT 40
+
+typedef struct {
+    // Rendering, measured in wall time around each LVGL render pass
+    uint32_t render_passes;
+    uint64_t render_ns_total;
+    uint64_t render_ns_max;
+    uint64_t flush_cb_ns_total;  // inside the display flush callback
+
+    // Panel traffic as seen by the virtual ST7789
+    uint32_t flushes;
+    uint64_t pixels_flushed;
+    uint64_t spi_bytes;
+    uint32_t spi_transactions;
+
+    // Sensor samples and the virtual time until they reach the panel
+    uint32_t samples;
+    uint32_t latency_count;
+    int64_t latency_us_total;
+    int64_t latency_us_max;
+    int64_t pending_sample_us;   // -1 when no sample is waiting for a flush
+
+    // Virtual time from a measurement becoming ready in the sensor to the
+    // driver reading it, and measurements overwritten before being read
+    uint32_t sensor_reads;
+    uint32_t sensor_missed;
+    int64_t sensor_latency_us_total;
+    int64_t sensor_latency_us_max;
+} sim_metrics_t;
+
+extern sim_metrics_t g_sim_metrics;
+
+// Virtual clock
+void sim_rtos_init(int64_t duration_us);
+int64_t sim_now_us(void);
+void sim_rtos_start(void);   // runs tasks until the duration is over
+uint64_t sim_wall_ns(void);
+
+// Host wall time is multiplied by this to estimate CPU time on the target
+// (ESP32 at 160 MHz against a desktop core)
+#define SIM_CPU_SCALE_DEFAULT 10.0
+void sim_rtos_set_cpu_scale(double scale);
+
+// Scripted GPIO inputs
+void sim_gpio_set_input(int pin, int level);
+int sim_gpio_get_output(int pin);
+
+// Sensor model
+void sim_scd41_seed(uint32_t seed);
+
+// Flash: mirror the sample log partition to a file (NULL keeps it in memory)
+void sim_partition_set_file(const char *path);
+
+// Seqlock stress run on real threads; returns non-zero on torn reads
+int sim_stress_snapshot(double seconds);
+
+// Label update micro-benchmark (sim_format_bench.c)
+int sim_bench_format(uint32_t updates);
+
+// Panel
+bool sim_panel_dump_ppm(const char *path);
+
+// Render benchmark (sim_bench.c). Configure before the run, start once the
+// display exists, finish after the run; returns the number of failures.
+void sim_bench_configure(const char *json_path, const char *thresholds_path, const char *record_path);
+void sim_bench_set_baseline(const char *json_path);
+bool sim_bench_enabled(void);
+double sim_bench_duration_s(void);
+void sim_bench_start(void);
+int sim_bench_finish(void);
+void sim_bench_on_sample(void);
+void sim_bench_on_render(uint64_t ns);
+void sim_bench_on_flush(uint32_t pixels);
+
+// Metrics hooks
+void sim_metrics_sample_ready(void);
+void sim_metrics_sensor_read(int64_t ready_us, uint32_t missed);
+void sim_metrics_flush(uint32_t pixels);
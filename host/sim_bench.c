@@ -0,0 +1,491 @@
+// Render benchmark: drives the unmodified firmware through a fixed script
+// of button presses and sensor samples and measures each scenario's render
+// passes, host render time, flushed pixels, invalidated area, draw tasks
+// and LVGL heap peak. Results are written as JSON and compared with a
+// threshold file; any metric above its limit fails the run. With a
+// baseline (the JSON of an earlier run, e.g. a build with an optimisation
+// turned off) every metric that differs is printed with its change.
+//
+// Objects are instrumented for draw task counting when their screen is
+// first rendered, and again after the screen registry rebuilds it.
+//
+// Script, after one warm-up tour of every screen:
+//   for each screen in firmware order, starting from the temperature graph
+//   and ending back on the sensor screen:
+//     <screen>_screen_load   one press of the next button
+//     <screen> update        the next BENCH_SAMPLES sensor samples: label
+//                            updates on the sensor screen, chart shifts on
+//                            the graphs, the 1 Hz refresh on diagnostics
+// Scenario windows never overlap a sample they do not belong to, so every
+// render pass in a window is caused by that scenario.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "lvgl.h"
+#include "lvgl_sched.h"
+#include "sim.h"
+
+#define BENCH_SCREENS       5
+#define BENCH_SAMPLES       4
+#define BENCH_PRESS_MS      200
+#define BENCH_SETTLE_MS     1500
+#define BENCH_MAX_LIMITS    64
+#define NEXT_SCREEN_GPIO    33
+
+typedef enum {
+    M_FRAMES_PER_EVENT,
+    M_MS_PER_FRAME,
+    M_PIXELS_PER_EVENT,
+    M_INVALIDATED_PX_PER_EVENT,
+    M_DRAW_TASKS_PER_EVENT,
+    M_HEAP_PEAK,
+    M_COUNT
+} bench_metric_t;
+
+static const char *const metric_names[M_COUNT] = {
+    [M_FRAMES_PER_EVENT] = "frames_per_event",
+    [M_MS_PER_FRAME] = "ms_per_frame",
+    [M_PIXELS_PER_EVENT] = "pixels_per_event",
+    [M_INVALIDATED_PX_PER_EVENT] = "invalidated_px_per_event",
+    [M_DRAW_TASKS_PER_EVENT] = "draw_tasks_per_event",
+    [M_HEAP_PEAK] = "heap_peak",
+};
+
+typedef struct {
+    const char *name;
+    uint32_t events;
+    uint32_t frames;
+    uint64_t render_ns;
+    uint64_t pixels;
+    uint64_t invalidated_px;
+    uint32_t draw_tasks;
+    uint32_t heap_peak;
+} bench_scenario_t;
+
+// Firmware screen order: sensor, temperature, humidity, CO2, diagnostics
+static bench_scenario_t s_loads[BENCH_SCREENS] = {
+    {.name = "sensor_screen_load"},
+    {.name = "temp_screen_load"},
+    {.name = "hum_screen_load"},
+    {.name = "co2_screen_load"},
+    {.name = "diag_screen_load"},
+};
+static bench_scenario_t s_updates[BENCH_SCREENS] = {
+    {.name = "sensor_label_update"},
+    {.name = "temp_chart_shift"},
+    {.name = "hum_chart_shift"},
+    {.name = "co2_chart_shift"},
+    {.name = "diag_refresh"},
+};
+
+typedef struct {
+    char scenario[32];      // "*" matches every scenario
+    bench_metric_t metric;
+    double max;
+} bench_limit_t;
+
+static const char *s_json_path = NULL;
+static const char *s_limits_path = NULL;
+static const char *s_record_path = NULL;
+static const char *s_baseline_path = NULL;
+static bench_limit_t s_limits[BENCH_MAX_LIMITS];
+static int s_limit_count = 0;
+
+static bench_scenario_t *s_active = NULL;
+static SemaphoreHandle_t s_sample_sem = NULL;
+static bool s_done = false;
+
+void sim_bench_configure(const char *json_path, const char *thresholds_path, const char *record_path)
+{
+    s_json_path = json_path;
+    s_limits_path = thresholds_path;
+    s_record_path = record_path;
+}
+
+void sim_bench_set_baseline(const char *json_path)
+{
+    s_baseline_path = json_path;
+}
+
+bool sim_bench_enabled(void)
+{
+    return s_json_path != NULL || s_record_path != NULL;
+}
+
+double sim_bench_duration_s(void)
+{
+    // Warm-up, then per screen a load and BENCH_SAMPLES samples of 5 s,
+    // with room for the sensor's slow clock
+    return 30.0 + BENCH_SCREENS * (5.0 + BENCH_SAMPLES * 5.1);
+}
+
+/* ----------------------------------------------------------------- hooks */
+
+void sim_bench_on_sample(void)
+{
+    if (s_sample_sem) {
+        xSemaphoreGive(s_sample_sem);
+    }
+}
+
+void sim_bench_on_render(uint64_t ns)
+{
+    if (s_active) {
+        s_active->frames++;
+        s_active->render_ns += ns;
+    }
+}
+
+void sim_bench_on_flush(uint32_t pixels)
+{
+    if (s_active) {
+        s_active->pixels += pixels;
+    }
+}
+
+static void heap_sample(void)
+{
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+    const uint32_t used = mon.total_size - mon.free_size;
+    if (used > s_active->heap_peak) {
+        s_active->heap_peak = used;
+    }
+}
+
+static void draw_task_event_cb(lv_event_t *e)
+{
+    if (s_active) {
+        s_active->draw_tasks++;
+    }
+}
+
+static lv_obj_tree_walk_res_t instrument_obj(lv_obj_t *obj, void *user_data)
+{
+    if (!lv_obj_has_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS)) {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+        lv_obj_add_event_cb(obj, draw_task_event_cb, LV_EVENT_DRAW_TASK_ADDED, NULL);
+    }
+    return LV_OBJ_TREE_WALK_NEXT;
+}
+
+static void display_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        lv_obj_t *screen = lv_display_get_screen_active(lv_event_get_target(e));
+        if (!lv_obj_has_flag(screen, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS)) {
+            lv_obj_tree_walk(screen, instrument_obj, NULL);
+        }
+        return;
+    }
+    if (!s_active) {
+        return;
+    }
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_INVALIDATE_AREA: {
+            const lv_area_t *area = lv_event_get_param(e);
+            s_active->invalidated_px += (uint64_t)lv_area_get_size(area);
+            break;
+        }
+        case LV_EVENT_FLUSH_START:
+        case LV_EVENT_RENDER_READY:
+            // Draw buffers and layers are allocated at these points
+            heap_sample();
+            break;
+        default:
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------- script */
+
+static void press_next(void)
+{
+    sim_gpio_set_input(NEXT_SCREEN_GPIO, 0);
+    vTaskDelay(pdMS_TO_TICKS(BENCH_PRESS_MS));
+    sim_gpio_set_input(NEXT_SCREEN_GPIO, 1);
+}
+
+static void wait_sample(void)
+{
+    xSemaphoreTake(s_sample_sem, portMAX_DELAY);
+}
+
+static void begin(bench_scenario_t *scenario)
+{
+    scenario->events++;
+    s_active = scenario;
+}
+
+static void end(void)
+{
+    s_active = NULL;
+}
+
+static void bench_task(void *arg)
+{
+    (void)arg;
+
+    // Warm-up tour: every screen gets built, loaded and rendered
+    wait_sample();
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    for (int i = 0; i < BENCH_SCREENS; i++) {
+        press_next();
+        vTaskDelay(pdMS_TO_TICKS(BENCH_SETTLE_MS));
+    }
+
+    // Each load starts 1.5 s after a sample and ends 1.5 s later; each
+    // update window opens 4 s after a sample and closes 1 s after the next.
+    // A sample that arrived during the tour must not count as the first.
+    xSemaphoreTake(s_sample_sem, 0);
+    wait_sample();
+    vTaskDelay(pdMS_TO_TICKS(BENCH_SETTLE_MS));
+    for (int step = 0; step < BENCH_SCREENS; step++) {
+        const int screen = (step + 1) % BENCH_SCREENS;
+
+        begin(&s_loads[screen]);
+        press_next();
+        vTaskDelay(pdMS_TO_TICKS(BENCH_SETTLE_MS - BENCH_PRESS_MS));
+        end();
+        vTaskDelay(pdMS_TO_TICKS(1000));
+
+        for (int k = 0; k < BENCH_SAMPLES; k++) {
+            begin(&s_updates[screen]);
+            wait_sample();
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            end();
+            vTaskDelay(pdMS_TO_TICKS(k < BENCH_SAMPLES - 1 ? 3000 : BENCH_SETTLE_MS - 1000));
+        }
+    }
+    s_done = true;
+    vTaskDelete(NULL);
+}
+
+void sim_bench_start(void)
+{
+    lv_display_t *disp = lv_display_get_default();
+
+    s_sample_sem = xSemaphoreCreateBinary();
+    if (lvgl_sched_lock(0)) {
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_START, NULL);
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_START, NULL);
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_READY, NULL);
+        lvgl_sched_unlock();
+    }
+    xTaskCreate(bench_task, "sim_bench", 4096, NULL, 1, NULL);
+}
+
+/* --------------------------------------------------------------- results */
+
+static double metric_value(const bench_scenario_t *s, bench_metric_t metric)
+{
+    const double events = s->events ? s->events : 1;
+
+    switch (metric) {
+        case M_FRAMES_PER_EVENT:
+            return s->frames / events;
+        case M_MS_PER_FRAME:
+            return s->frames ? s->render_ns / 1e6 / s->frames : 0.0;
+        case M_PIXELS_PER_EVENT:
+            return s->pixels / events;
+        case M_INVALIDATED_PX_PER_EVENT:
+            return s->invalidated_px / events;
+        case M_DRAW_TASKS_PER_EVENT:
+            return s->draw_tasks / events;
+        case M_HEAP_PEAK:
+            return s->heap_peak;
+        default:
+            return 0.0;
+    }
+}
+
+static bool load_limits(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[128];
+
+    if (!f) {
+        fprintf(stderr, "bench: cannot open %s\n", path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), f) && s_limit_count < BENCH_MAX_LIMITS) {
+        char scenario[32], metric[32];
+        double max;
+        if (line[0] == '#' || sscanf(line, "%31s %31s %lf", scenario, metric, &max) != 3) {
+            continue;
+        }
+        for (int m = 0; m < M_COUNT; m++) {
+            if (!strcmp(metric, metric_names[m])) {
+                bench_limit_t *limit = &s_limits[s_limit_count++];
+                snprintf(limit->scenario, sizeof(limit->scenario), "%s", scenario);
+                limit->metric = (bench_metric_t)m;
+                limit->max = max;
+                break;
+            }
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Writes one scenario object; returns the number of limits it exceeds
+static int write_scenario(FILE *f, const bench_scenario_t *s, bool last)
+{
+    int failed = 0;
+
+    fprintf(f, "    {\"name\": \"%s\", \"events\": %u, \"frames\": %u", s->name, s->events, s->frames);
+    for (int m = 0; m < M_COUNT; m++) {
+        fprintf(f, ", \"%s\": %.3f", metric_names[m], metric_value(s, (bench_metric_t)m));
+    }
+    fprintf(f, ", \"failed\": [");
+    // A scenario that never ran is a failure of the script itself
+    if (s->events == 0) {
+        fprintf(f, "\"events\"");
+        failed++;
+    }
+    for (int i = 0; i < s_limit_count; i++) {
+        const bench_limit_t *limit = &s_limits[i];
+        if (strcmp(limit->scenario, "*") && strcmp(limit->scenario, s->name)) {
+            continue;
+        }
+        const double value = metric_value(s, limit->metric);
+        if (value > limit->max) {
+            fprintf(f, "%s{\"metric\": \"%s\", \"value\": %.3f, \"max\": %.3f}", failed ? ", " : "",
+                    metric_names[limit->metric], value, limit->max);
+            fprintf(stderr, "bench: %s %s=%.3f exceeds %.3f\n", s->name, metric_names[limit->metric],
+                    value, limit->max);
+            failed++;
+        }
+    }
+    fprintf(f, "]}%s\n", last ? "" : ",");
+    return failed;
+}
+
+// Deterministic metrics get 10% headroom, host time and heap more
+static void record_limits(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    const bench_scenario_t *all[2 * BENCH_SCREENS];
+
+    if (!f) {
+        fprintf(stderr, "bench: cannot write %s\n", path);
+        return;
+    }
+    for (int i = 0; i < BENCH_SCREENS; i++) {
+        all[2 * i] = &s_loads[i];
+        all[2 * i + 1] = &s_updates[i];
+    }
+    char host[64] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    fprintf(f, "# Recorded with --bench-record on %s; scenario metric max\n", host);
+    for (int i = 0; i < 2 * BENCH_SCREENS; i++) {
+        for (int m = 0; m < M_COUNT; m++) {
+            const double value = metric_value(all[i], (bench_metric_t)m);
+            double max = value * 1.10 + 1;
+            if (m == M_MS_PER_FRAME) {
+                max = value * 3.0 + 1;
+            } else if (m == M_HEAP_PEAK) {
+                max = value * 1.25;
+            }
+            fprintf(f, "%-22s %-26s %.0f\n", all[i]->name, metric_names[m], max);
+        }
+    }
+    fclose(f);
+}
+
+static const bench_scenario_t *find_scenario(const char *name)
+{
+    for (int i = 0; i < BENCH_SCREENS; i++) {
+        if (!strcmp(s_loads[i].name, name)) {
+            return &s_loads[i];
+        }
+        if (!strcmp(s_updates[i].name, name)) {
+            return &s_updates[i];
+        }
+    }
+    return NULL;
+}
+
+// Reads the scenario lines write_scenario() produced in an earlier run
+static void compare_baseline(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[512];
+
+    if (!f) {
+        fprintf(stderr, "bench: cannot open baseline %s\n", path);
+        return;
+    }
+    printf("bench: changes against %s\n", path);
+    while (fgets(line, sizeof(line), f)) {
+        char name[32];
+        if (sscanf(line, " {\"name\": \"%31[^\"]\"", name) != 1) {
+            continue;
+        }
+        const bench_scenario_t *s = find_scenario(name);
+        if (!s) {
+            continue;
+        }
+        for (int m = 0; m < M_COUNT; m++) {
+            char key[40];
+            snprintf(key, sizeof(key), "\"%s\": ", metric_names[m]);
+            const char *field = strstr(line, key);
+            if (!field) {
+                continue;
+            }
+            const double base = atof(field + strlen(key));
+            const double value = metric_value(s, (bench_metric_t)m);
+            if (value == base) {
+                continue;
+            }
+            printf("bench: %-22s %-26s %10.3f -> %10.3f", name, metric_names[m], base, value);
+            if (base != 0) {
+                printf(" (%+.1f%%)", (value - base) * 100.0 / base);
+            }
+            printf("\n");
+        }
+    }
+    fclose(f);
+}
+
+int sim_bench_finish(void)
+{
+    int failed = 0;
+
+    if (!s_done) {
+        fprintf(stderr, "bench: script did not finish within the run\n");
+        failed++;
+    }
+    if (s_limits_path && !load_limits(s_limits_path)) {
+        failed++;
+    }
+    if (s_record_path) {
+        record_limits(s_record_path);
+    }
+    if (s_baseline_path) {
+        compare_baseline(s_baseline_path);
+    }
+    if (!s_json_path) {
+        return failed;
+    }
+
+    FILE *f = fopen(s_json_path, "w");
+    if (!f) {
+        fprintf(stderr, "bench: cannot write %s\n", s_json_path);
+        return failed + 1;
+    }
+    fprintf(f, "{\n  \"samples_per_update\": %d,\n  \"scenarios\": [\n", BENCH_SAMPLES);
+    for (int i = 0; i < BENCH_SCREENS; i++) {
+        failed += write_scenario(f, &s_loads[i], false);
+        failed += write_scenario(f, &s_updates[i], i == BENCH_SCREENS - 1);
+    }
+    fprintf(f, "  ],\n  \"failures\": %d\n}\n", failed);
+    fclose(f);
+    return failed;
+}
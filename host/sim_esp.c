@@ -0,0 +1,240 @@
+// ESP-IDF system shims for the host build: logging, esp_timer, GPIO with
+// interrupts, sleep wakeup, shutdown handlers and the SPI bus.
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_task_wdt.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "driver/spi_master.h"
+#include "sim.h"
+
+static esp_log_level_t s_log_level = ESP_LOG_INFO;
+static pthread_mutex_t s_log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int s_gpio_level[SIM_GPIO_COUNT];
+static gpio_mode_t s_gpio_mode[SIM_GPIO_COUNT];
+
+static struct {
+    gpio_int_type_t type;
+    bool enabled;
+    gpio_isr_t isr;
+    void *arg;
+} s_gpio_intr[SIM_GPIO_COUNT];
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    s_log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    (void)tag;
+    if (level > s_log_level) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    pthread_mutex_lock(&s_log_lock);
+    printf("[%10.3f] ", sim_now_us() / 1e6);
+    vprintf(format, args);
+    pthread_mutex_unlock(&s_log_lock);
+    va_end(args);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_now_us();
+}
+
+esp_err_t esp_task_wdt_reset(void)
+{
+    return ESP_OK;
+}
+
+/* ----------------------------------------------------------------- GPIO */
+
+esp_err_t gpio_config(const gpio_config_t *conf)
+{
+    for (int pin = 0; pin < SIM_GPIO_COUNT; pin++) {
+        if (!(conf->pin_bit_mask & (1ULL << pin))) {
+            continue;
+        }
+        s_gpio_mode[pin] = conf->mode;
+        s_gpio_intr[pin].type = conf->intr_type;
+        if (conf->mode == GPIO_MODE_INPUT && conf->pull_up_en) {
+            s_gpio_level[pin] = 1;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    __atomic_store_n(&s_gpio_level[gpio_num], level ? 1 : 0, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return 0;
+    }
+    return __atomic_load_n(&s_gpio_level[gpio_num], __ATOMIC_RELAXED);
+}
+
+// Fire the handler if the pin's interrupt condition holds. Edges are
+// passed in by the caller that changed the level.
+static void gpio_intr_check(int pin, int old_level)
+{
+    const int level = gpio_get_level((gpio_num_t)pin);
+    bool fire = false;
+
+    if (!s_gpio_intr[pin].enabled || !s_gpio_intr[pin].isr) {
+        return;
+    }
+    switch (s_gpio_intr[pin].type) {
+        case GPIO_INTR_POSEDGE:
+            fire = old_level == 0 && level == 1;
+            break;
+        case GPIO_INTR_NEGEDGE:
+            fire = old_level == 1 && level == 0;
+            break;
+        case GPIO_INTR_ANYEDGE:
+            fire = old_level != level;
+            break;
+        case GPIO_INTR_LOW_LEVEL:
+            fire = level == 0;
+            break;
+        case GPIO_INTR_HIGH_LEVEL:
+            fire = level == 1;
+            break;
+        default:
+            break;
+    }
+    if (fire) {
+        s_gpio_intr[pin].isr(s_gpio_intr[pin].arg);
+    }
+}
+
+void sim_gpio_set_input(int pin, int level)
+{
+    const int old_level = gpio_get_level((gpio_num_t)pin);
+    gpio_set_level((gpio_num_t)pin, level);
+    if (pin >= 0 && pin < SIM_GPIO_COUNT) {
+        gpio_intr_check(pin, old_level);
+    }
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_gpio_intr[gpio_num].isr = isr_handler;
+    s_gpio_intr[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_gpio_intr[gpio_num].type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_gpio_intr[gpio_num].enabled = true;
+    // A level that already holds fires at once
+    const int level = gpio_get_level(gpio_num);
+    gpio_intr_check(gpio_num, level);
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= SIM_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_gpio_intr[gpio_num].enabled = false;
+    return ESP_OK;
+}
+
+// The simulation never sleeps; only the trigger type matters
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    if (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return gpio_set_intr_type(gpio_num, intr_type);
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void)
+{
+    return ESP_OK;
+}
+
+// The simulation never restarts, so handlers are only accepted
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle)
+{
+    return handle != NULL ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int sim_gpio_get_output(int pin)
+{
+    return gpio_get_level((gpio_num_t)pin);
+}
+
+/* ------------------------------------------------------------------ SPI */
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config,
+                             spi_dma_chan_t dma_chan)
+{
+    (void)host_id;
+    (void)dma_chan;
+    return bus_config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
@@ -0,0 +1,105 @@
+// Micro-benchmark of one reading label update, outside the virtual clock:
+// the snprintf + lv_label_set_text path the firmware used against
+// value_format() + lv_label_set_text_static(). Cycles are host wall time
+// scaled like perf_cycles(), so only the ratio is meaningful.
+#include <stdio.h>
+#include "lvgl.h"
+#include "perf.h"
+#include "value_format.h"
+#include "sim.h"
+
+#define BATCH 1000      // updates per perf_cycles() reading, well inside its wrap
+
+typedef void (*update_fn_t)(lv_obj_t *label, int32_t value, bool tenths);
+
+static char s_text[VALUE_FORMAT_MAX];
+static volatile size_t s_sink;
+
+static size_t format_snprintf(char *buf, size_t size, int32_t value, bool tenths)
+{
+    if (tenths) {
+        uint32_t mag = value < 0 ? -value : value;
+        return snprintf(buf, size, "%s%s%u.%u %s", ": ", value < 0 ? "-" : "", (unsigned)(mag / 10),
+                        (unsigned)(mag % 10), "C");
+    }
+    return snprintf(buf, size, "%s%d %s", ": ", (int)value, "ppm");
+}
+
+static size_t format_integer(char *buf, size_t size, int32_t value, bool tenths)
+{
+    return value_format(buf, size, ": ", value, tenths, tenths ? "C" : "ppm");
+}
+
+static void format_only_before(lv_obj_t *label, int32_t value, bool tenths)
+{
+    char text[32];
+    s_sink += format_snprintf(text, sizeof(text), value, tenths);
+}
+
+static void format_only_after(lv_obj_t *label, int32_t value, bool tenths)
+{
+    s_sink += format_integer(s_text, sizeof(s_text), value, tenths);
+}
+
+static void update_before(lv_obj_t *label, int32_t value, bool tenths)
+{
+    char text[32];
+    format_snprintf(text, sizeof(text), value, tenths);
+    lv_label_set_text(label, text);
+}
+
+static void update_after(lv_obj_t *label, int32_t value, bool tenths)
+{
+    format_integer(s_text, sizeof(s_text), value, tenths);
+    lv_label_set_text_static(label, s_text);
+}
+
+// Alternating CO2 and temperature values that change every update
+static double cycles_per_update(update_fn_t fn, lv_obj_t *label, uint32_t updates)
+{
+    uint64_t cycles = 0;
+    uint32_t done = 0;
+
+    while (done < updates) {
+        const uint32_t start = perf_cycles();
+        for (uint32_t i = 0; i < BATCH; i++, done++) {
+            fn(label, done & 1 ? 400 + (int32_t)(done % 1600) : 180 + (int32_t)(done % 120), done & 1);
+        }
+        cycles += perf_cycles() - start;
+    }
+    return (double)cycles / done;
+}
+
+static uint32_t heap_used(void)
+{
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+int sim_bench_format(uint32_t updates)
+{
+    lv_init();
+    lv_display_create(320, 240);
+    lv_obj_t *label = lv_label_create(lv_screen_active());
+
+    const double fmt_before = cycles_per_update(format_only_before, label, updates);
+    const double fmt_after = cycles_per_update(format_only_after, label, updates);
+
+    // The label's heap copy of its text is what the static text saves
+    lv_label_set_text_static(label, "");
+    const uint32_t base = heap_used();
+    const double before = cycles_per_update(update_before, label, updates);
+    const uint32_t before_heap = heap_used() - base;
+    const double after = cycles_per_update(update_after, label, updates);
+    const uint32_t after_heap = heap_used() - base;
+
+    printf("format_updates=%u format_cycles_before=%.0f format_cycles_after=%.0f\n", (unsigned)updates,
+           fmt_before, fmt_after);
+    printf("label_update_cycles_before=%.0f label_update_cycles_after=%.0f speedup=%.1f\n", before, after,
+           after > 0 ? before / after : 0);
+    printf("label_text_heap_bytes_before=%u label_text_heap_bytes_after=%u\n", (unsigned)before_heap,
+           (unsigned)after_heap);
+    return 0;
+}
@@ -0,0 +1,364 @@
+// Entry point of the host simulation: runs app_main on the virtual clock for
+// a given duration, optionally presses buttons on a schedule, and prints
+// frame cost, heap use and sample-to-pixel latency.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "lvgl.h"
+#include "lvgl_sched.h"
+#include "power.h"
+#include "input.h"
+#include "sample_log.h"
+#include "st7789.h"
+#include "scd41_async.h"
+#include "perf.h"
+#include "screen_registry.h"
+#include "ui_theme.h"
+#include "sim.h"
+
+#define ON_OFF_GPIO      32
+#define NEXT_SCREEN_GPIO 33
+#define BUTTON_HOLD_MS   200
+
+sim_metrics_t g_sim_metrics = {
+    .pending_sample_us = -1,
+};
+
+static pthread_mutex_t s_metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t s_press_period_s = 0;
+static uint32_t s_screen_off_s = 0;
+
+extern void app_main(void);
+
+void sim_metrics_sample_ready(void)
+{
+    pthread_mutex_lock(&s_metrics_lock);
+    g_sim_metrics.samples++;
+    if (g_sim_metrics.pending_sample_us < 0) {
+        g_sim_metrics.pending_sample_us = sim_now_us();
+    }
+    pthread_mutex_unlock(&s_metrics_lock);
+    sim_bench_on_sample();
+}
+
+void sim_metrics_sensor_read(int64_t ready_us, uint32_t missed)
+{
+    int64_t latency = sim_now_us() - ready_us;
+
+    pthread_mutex_lock(&s_metrics_lock);
+    g_sim_metrics.sensor_reads++;
+    g_sim_metrics.sensor_missed += missed;
+    g_sim_metrics.sensor_latency_us_total += latency;
+    if (latency > g_sim_metrics.sensor_latency_us_max) {
+        g_sim_metrics.sensor_latency_us_max = latency;
+    }
+    pthread_mutex_unlock(&s_metrics_lock);
+}
+
+void sim_metrics_flush(uint32_t pixels)
+{
+    pthread_mutex_lock(&s_metrics_lock);
+    g_sim_metrics.flushes++;
+    g_sim_metrics.pixels_flushed += pixels;
+    sim_bench_on_flush(pixels);
+    if (g_sim_metrics.pending_sample_us >= 0) {
+        int64_t latency = sim_now_us() - g_sim_metrics.pending_sample_us;
+        g_sim_metrics.latency_count++;
+        g_sim_metrics.latency_us_total += latency;
+        if (latency > g_sim_metrics.latency_us_max) {
+            g_sim_metrics.latency_us_max = latency;
+        }
+        g_sim_metrics.pending_sample_us = -1;
+    }
+    pthread_mutex_unlock(&s_metrics_lock);
+}
+
+static void render_event_cb(lv_event_t *e)
+{
+    static uint64_t start_ns;
+
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        start_ns = sim_wall_ns();
+        return;
+    }
+    uint64_t ns = sim_wall_ns() - start_ns;
+    g_sim_metrics.render_passes++;
+    g_sim_metrics.render_ns_total += ns;
+    if (ns > g_sim_metrics.render_ns_max) {
+        g_sim_metrics.render_ns_max = ns;
+    }
+    sim_bench_on_render(ns);
+}
+
+static void flush_event_cb(lv_event_t *e)
+{
+    static uint64_t start_ns;
+
+    if (lv_event_get_code(e) == LV_EVENT_FLUSH_START) {
+        start_ns = sim_wall_ns();
+        return;
+    }
+    g_sim_metrics.flush_cb_ns_total += sim_wall_ns() - start_ns;
+}
+
+static void app_task(void *arg)
+{
+    (void)arg;
+    app_main();
+}
+
+// One press of the on/off button: the screen stays off for the rest of the run
+static void screen_off_task(void *arg)
+{
+    (void)arg;
+    vTaskDelay(pdMS_TO_TICKS(s_screen_off_s * 1000));
+    sim_gpio_set_input(ON_OFF_GPIO, 0);
+    vTaskDelay(pdMS_TO_TICKS(BUTTON_HOLD_MS));
+    sim_gpio_set_input(ON_OFF_GPIO, 1);
+}
+
+// Runs once app_main has blocked, i.e. after the display exists
+static void monitor_task(void *arg)
+{
+    (void)arg;
+    lv_display_t *disp = lv_display_get_default();
+    if (disp) {
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_START, NULL);
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_READY, NULL);
+        lv_display_add_event_cb(disp, flush_event_cb, LV_EVENT_FLUSH_START, NULL);
+        lv_display_add_event_cb(disp, flush_event_cb, LV_EVENT_FLUSH_FINISH, NULL);
+    }
+
+    if (sim_bench_enabled()) {
+        sim_bench_start();
+        vTaskDelete(NULL);
+    }
+    if (s_screen_off_s > 0) {
+        xTaskCreate(screen_off_task, "sim_power", 2048, NULL, 1, NULL);
+    }
+    if (s_press_period_s == 0) {
+        vTaskDelete(NULL);
+    }
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(s_press_period_s * 1000));
+        sim_gpio_set_input(NEXT_SCREEN_GPIO, 0);
+        vTaskDelay(pdMS_TO_TICKS(BUTTON_HOLD_MS));
+        sim_gpio_set_input(NEXT_SCREEN_GPIO, 1);
+    }
+}
+
+
+static void print_report(double duration_s, uint64_t wall_ns)
+{
+    const sim_metrics_t *m = &g_sim_metrics;
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    printf("virtual_s=%.1f wall_s=%.3f speedup=%.0f\n",
+           duration_s, wall_ns / 1e9, duration_s / (wall_ns / 1e9));
+    printf("samples=%u\n", m->samples);
+    printf("render_passes=%u render_ms_avg=%.3f render_ms_max=%.3f\n",
+           m->render_passes,
+           m->render_passes ? m->render_ns_total / 1e6 / m->render_passes : 0.0,
+           m->render_ns_max / 1e6);
+    printf("flush_cb_ms_per_frame=%.3f\n",
+           m->render_passes ? m->flush_cb_ns_total / 1e6 / m->render_passes : 0.0);
+    printf("flushes=%u pixels=%llu spi_bytes=%llu spi_transactions=%u\n",
+           m->flushes, (unsigned long long)m->pixels_flushed,
+           (unsigned long long)m->spi_bytes, m->spi_transactions);
+    printf("sample_to_pixel_ms_avg=%.1f sample_to_pixel_ms_max=%.1f\n",
+           m->latency_count ? m->latency_us_total / 1e3 / m->latency_count : 0.0,
+           m->latency_us_max / 1e3);
+    scd41_async_stats_t scd;
+    scd41_async_get_stats(&scd);
+    printf("scd41_samples=%u scd41_dropped=%u scd41_transactions=%u scd41_bytes=%llu scd41_polls=%u "
+           "scd41_not_ready=%u scd41_crc_errors=%u scd41_bus_errors=%u scd41_ready_window_ms_max=%.1f\n",
+           scd.samples, scd.dropped, scd.transactions, (unsigned long long)scd.bytes, scd.polls,
+           scd.not_ready, scd.crc_errors, scd.bus_errors, scd.ready_window_us_max / 1e3);
+    printf("sensor_reads=%u sensor_missed=%u ready_to_read_ms_avg=%.1f ready_to_read_ms_max=%.1f\n",
+           m->sensor_reads, m->sensor_missed,
+           m->sensor_reads ? m->sensor_latency_us_total / 1e3 / m->sensor_reads : 0.0,
+           m->sensor_latency_us_max / 1e3);
+    lvgl_sched_stats_t sched;
+    lvgl_sched_get_stats(&sched);
+    printf("lvgl_wakeups=%u lvgl_wakeups_per_s=%.2f lvgl_notified=%u lvgl_coalesced=%u lvgl_render_passes=%u\n",
+           sched.wakeups, duration_s > 0 ? sched.wakeups / duration_s : 0.0,
+           sched.notified, sched.coalesced, sched.render_passes);
+    st7789_flush_stats_t fl;
+    st7789_get_flush_stats(&fl);
+    printf("flush_frames=%u flush_areas=%u flush_bytes=%llu flush_transactions=%u "
+           "flush_bytes_per_frame=%.0f last_frame_bytes=%u last_frame_areas=%u\n",
+           fl.frames, fl.areas, (unsigned long long)fl.bytes, fl.transactions,
+           fl.frames ? (double)fl.bytes / fl.frames : 0.0, fl.last_frame_bytes, fl.last_frame_areas);
+    input_stats_t in;
+    input_get_stats(&in);
+    printf("input_interrupts=%u input_bounces=%u input_short=%u input_long=%u input_double=%u "
+           "input_to_screen_ms_avg=%.1f input_to_screen_ms_max=%.1f\n",
+           in.interrupts, in.bounces, in.gestures[INPUT_SHORT_PRESS], in.gestures[INPUT_LONG_PRESS],
+           in.gestures[INPUT_DOUBLE_PRESS],
+           in.latency_count ? in.latency_us_total / 1e3 / in.latency_count : 0.0, in.latency_us_max / 1e3);
+    energy_report_t energy;
+    power_get_report(&energy);
+    printf("energy_uah=%.1f energy_avg_ua=%u energy_runtime_h_2000mah=%u",
+           energy.total_nah / 1e3, energy.avg_ua, energy_model_runtime_h(&energy, 2000));
+    for (int rail = 0; rail < ENERGY_RAIL_COUNT; rail++) {
+        printf(" %s_duty_pm=%u %s_uah=%.1f", energy_rail_name(rail), energy.duty_permille[rail],
+               energy_rail_name(rail), energy.charge_nah[rail] / 1e3);
+    }
+    printf("\n");
+    sample_log_stats_t log;
+    sample_log_get_stats(&log);
+    uint64_t payload = (uint64_t)log.records * 8;
+    printf("log_records=%u log_dropped=%u log_keyframes=%u log_bytes_written=%llu log_sectors_erased=%u "
+           "log_write_amp=%.2f log_boot_scan_us=%u log_restore_us=%u\n",
+           log.records, log.dropped, log.keyframes, (unsigned long long)log.bytes_written, log.sectors_erased,
+           payload ? (double)(log.bytes_written + log.bytes_erased) / payload : 0.0,
+           log.boot_scan_us, log.restore_us);
+    printf("lv_heap_used=%u lv_heap_max_used=%u lv_heap_frag_pct=%u\n",
+           (unsigned)(mon.total_size - mon.free_size), (unsigned)mon.max_used, (unsigned)mon.frag_pct);
+    // Virtual time: waits during boot count, CPU time does not (see the
+    // screen_build histogram for that)
+    screen_registry_stats_t scr;
+    screen_registry_get_stats(&scr);
+    printf("boot_first_frame_ms=%.1f boot_lv_heap_peak=%u screen_builds=%u screen_prebuilds=%u "
+           "screen_evictions=%u screen_build_us_max=%u screens_built=%u\n",
+           scr.first_frame_us / 1e3, (unsigned)scr.first_frame_heap_peak, scr.builds, scr.prebuilds,
+           scr.evictions, scr.build_us_max, scr.built);
+    ui_theme_stats_t theme;
+    ui_theme_get_stats(&theme);
+    printf("theme_styled_objects=%u theme_heap_bytes=%u theme_heap_bytes_per_object=%.1f\n", theme.objects,
+           theme.heap_bytes, theme.objects ? (double)theme.heap_bytes / theme.objects : 0.0);
+    // Same histograms as the diagnostics screen, in target microseconds
+    for (int i = 0; i < perf_hist_count(); i++) {
+        const perf_hist_t *h = perf_hist_get(i);
+        printf("perf_%s_n=%u perf_%s_avg_us=%u perf_%s_p50_us=%u perf_%s_p95_us=%u perf_%s_max_us=%u\n",
+               h->name, h->count, h->name, h->count ? (unsigned)(h->total_us / h->count) : 0,
+               h->name, perf_hist_percentile(h, 50), h->name, perf_hist_percentile(h, 95), h->name, h->max_us);
+    }
+    static perf_tasks_t tasks;
+    perf_tasks_sample(&tasks);
+    for (int i = 0; i < tasks.count; i++) {
+        printf("task_%s_cpu_pm=%u ", tasks.tasks[i].name, tasks.tasks[i].cpu_permille);
+    }
+    printf("\n");
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--duration S] [--press-next S] [--seed N] [--ppm FILE] [--flash FILE]\n"
+            "          [--screen-off S] [--cpu-scale X] [--quiet]\n"
+            "       %s --bench FILE [--bench-thresholds FILE] [--bench-record FILE]\n"
+            "          [--bench-baseline FILE]\n"
+            "       %s --stress-snapshot S\n"
+            "       %s --bench-format N\n"
+            "  --duration S    virtual seconds to run (default 600)\n"
+            "  --press-next S  press the next-screen button every S seconds\n"
+            "  --seed N        sensor noise seed\n"
+            "  --ppm FILE      write the final panel contents as a PPM image\n"
+            "  --flash FILE    keep the sample log partition in FILE across runs\n"
+            "  --screen-off S  press the on/off button once after S seconds\n"
+            "  --cpu-scale X   host wall time to target CPU time factor for the\n"
+            "                  energy estimate (default %.0f)\n"
+            "  --quiet         only log warnings and errors\n"
+            "  --stress-snapshot S  hammer the sensor snapshot from several threads\n"
+            "                  for S wall seconds instead of running the firmware\n"
+            "  --bench-format N  time N reading label updates, snprintf against the\n"
+            "                  integer formatter, instead of running the firmware\n"
+            "  --bench FILE    run the render benchmark script instead of the\n"
+            "                  scripted inputs above and write JSON results\n"
+            "  --bench-thresholds FILE  fail (exit 1) if a metric exceeds its limit\n"
+            "  --bench-record FILE      write limits from this run, with headroom\n"
+            "  --bench-baseline FILE    print changes against an earlier --bench JSON\n",
+            prog, prog, prog, prog, SIM_CPU_SCALE_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+    double duration_s = 600;
+    const char *ppm_path = NULL;
+    const char *bench_path = NULL;
+    const char *bench_limits_path = NULL;
+    const char *bench_record_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "--duration") && val) {
+            duration_s = atof(val);
+            i++;
+        } else if (!strcmp(arg, "--press-next") && val) {
+            s_press_period_s = (uint32_t)atoi(val);
+            i++;
+        } else if (!strcmp(arg, "--seed") && val) {
+            sim_scd41_seed((uint32_t)strtoul(val, NULL, 0));
+            i++;
+        } else if (!strcmp(arg, "--ppm") && val) {
+            ppm_path = val;
+            i++;
+        } else if (!strcmp(arg, "--flash") && val) {
+            sim_partition_set_file(val);
+            i++;
+        } else if (!strcmp(arg, "--screen-off") && val) {
+            s_screen_off_s = (uint32_t)atoi(val);
+            i++;
+        } else if (!strcmp(arg, "--cpu-scale") && val) {
+            sim_rtos_set_cpu_scale(atof(val));
+            i++;
+        } else if (!strcmp(arg, "--bench") && val) {
+            bench_path = val;
+            i++;
+        } else if (!strcmp(arg, "--bench-thresholds") && val) {
+            bench_limits_path = val;
+            i++;
+        } else if (!strcmp(arg, "--bench-record") && val) {
+            bench_record_path = val;
+            i++;
+        } else if (!strcmp(arg, "--bench-baseline") && val) {
+            sim_bench_set_baseline(val);
+            i++;
+        } else if (!strcmp(arg, "--stress-snapshot") && val) {
+            return sim_stress_snapshot(atof(val));
+        } else if (!strcmp(arg, "--bench-format") && val) {
+            return sim_bench_format((uint32_t)strtoul(val, NULL, 0));
+        } else if (!strcmp(arg, "--quiet")) {
+            esp_log_level_set("*", ESP_LOG_WARN);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    sim_bench_configure(bench_path, bench_limits_path, bench_record_path);
+    if (sim_bench_enabled()) {
+        duration_s = sim_bench_duration_s();
+    }
+
+    sim_rtos_init((int64_t)(duration_s * 1e6));
+    xTaskCreate(app_task, "main", 3584, NULL, 1, NULL);
+    xTaskCreate(monitor_task, "sim_monitor", 2048, NULL, 1, NULL);
+
+    uint64_t wall_start = sim_wall_ns();
+    sim_rtos_start();
+    uint64_t wall_ns = sim_wall_ns() - wall_start;
+
+    print_report(duration_s, wall_ns);
+    if (ppm_path && !sim_panel_dump_ppm(ppm_path)) {
+        fprintf(stderr, "could not write %s\n", ppm_path);
+    }
+    int status = 0;
+    if (sim_bench_enabled()) {
+        const int failures = sim_bench_finish();
+        printf("bench_failures=%d\n", failures);
+        status = failures ? 1 : 0;
+    }
+
+    // Task threads are parked for good; skip joining them
+    fflush(stdout);
+    _exit(status);
+}
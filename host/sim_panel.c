@@ -0,0 +1,378 @@
+// Headless ST7789 for the host build. The esp_lcd panel IO shim feeds raw
+// commands into a model of the controller (address window, MADCTL,
+// vertical scroll, sleep) backed by an in-memory 240x320 frame buffer, and
+// counts the SPI traffic a real bus would carry.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_panel_ops.h"
+#include "sim.h"
+
+#define PANEL_W 240
+#define PANEL_H 320
+
+#define CMD_SWRESET 0x01
+#define CMD_SLPIN   0x10
+#define CMD_SLPOUT  0x11
+#define CMD_INVOFF  0x20
+#define CMD_INVON   0x21
+#define CMD_DISPOFF 0x28
+#define CMD_DISPON  0x29
+#define CMD_CASET   0x2A
+#define CMD_RASET   0x2B
+#define CMD_RAMWR   0x2C
+#define CMD_VSCRDEF 0x33
+#define CMD_MADCTL  0x36
+#define CMD_VSCSAD  0x37
+#define CMD_COLMOD  0x3A
+#define CMD_RAMWRC  0x3C
+
+#define MADCTL_MY   0x80
+#define MADCTL_MX   0x40
+#define MADCTL_MV   0x20
+
+struct esp_lcd_panel_io_t {
+    unsigned int pclk_hz;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void *user_ctx;
+};
+
+struct esp_lcd_panel_t {
+    esp_lcd_panel_io_handle_t io;
+    uint8_t madctl;
+};
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint16_t mem[PANEL_H][PANEL_W];
+    uint8_t madctl;
+    uint16_t xs, xe, ys, ye;   // logical address window, inclusive
+    uint16_t cx, cy;           // write pointer
+    uint16_t tfa, vsa, bfa, vsp;
+    bool sleeping;
+    bool display_on;
+    bool inverted;
+} st7789_model_t;
+
+static st7789_model_t s_panel = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .vsa = PANEL_H,
+    .sleeping = true,
+};
+
+static void model_reset(st7789_model_t *p)
+{
+    p->madctl = 0;
+    p->xs = p->ys = p->cx = p->cy = 0;
+    p->xe = PANEL_W - 1;
+    p->ye = PANEL_H - 1;
+    p->tfa = p->bfa = p->vsp = 0;
+    p->vsa = PANEL_H;
+    p->sleeping = true;
+    p->display_on = false;
+    p->inverted = false;
+}
+
+static uint16_t be16(const uint8_t *b)
+{
+    return (uint16_t)((b[0] << 8) | b[1]);
+}
+
+// Logical (MADCTL-transformed) coordinates to frame memory row/column
+static void model_map(const st7789_model_t *p, int lx, int ly, int *row, int *col)
+{
+    int c = lx;
+    int r = ly;
+    if (p->madctl & MADCTL_MV) {
+        c = ly;
+        r = lx;
+    }
+    if (p->madctl & MADCTL_MX) {
+        c = PANEL_W - 1 - c;
+    }
+    if (p->madctl & MADCTL_MY) {
+        r = PANEL_H - 1 - r;
+    }
+    *row = r;
+    *col = c;
+}
+
+static void model_command(st7789_model_t *p, int cmd, const uint8_t *param, size_t size)
+{
+    switch (cmd) {
+        case CMD_SWRESET:
+            model_reset(p);
+            break;
+        case CMD_SLPIN:
+            p->sleeping = true;
+            break;
+        case CMD_SLPOUT:
+            p->sleeping = false;
+            break;
+        case CMD_INVOFF:
+        case CMD_INVON:
+            p->inverted = cmd == CMD_INVON;
+            break;
+        case CMD_DISPOFF:
+        case CMD_DISPON:
+            p->display_on = cmd == CMD_DISPON;
+            break;
+        case CMD_CASET:
+            if (size >= 4) {
+                p->xs = be16(param);
+                p->xe = be16(param + 2);
+            }
+            break;
+        case CMD_RASET:
+            if (size >= 4) {
+                p->ys = be16(param);
+                p->ye = be16(param + 2);
+            }
+            break;
+        case CMD_MADCTL:
+            if (size >= 1) {
+                p->madctl = param[0];
+            }
+            break;
+        case CMD_VSCRDEF:
+            if (size >= 6) {
+                p->tfa = be16(param);
+                p->vsa = be16(param + 2);
+                p->bfa = be16(param + 4);
+            }
+            break;
+        case CMD_VSCSAD:
+            if (size >= 2) {
+                p->vsp = be16(param);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void model_write_pixels(st7789_model_t *p, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        int row, col;
+        model_map(p, p->cx, p->cy, &row, &col);
+        if (row >= 0 && row < PANEL_H && col >= 0 && col < PANEL_W) {
+            // The bus is MSB first: the first byte is the high half of the pixel
+            p->mem[row][col] = be16(data + i);
+        }
+        if (++p->cx > p->xe) {
+            p->cx = p->xs;
+            if (++p->cy > p->ye) {
+                p->cy = p->ys;
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------ panel IO */
+
+esp_err_t esp_lcd_new_panel_io_spi(esp_lcd_spi_bus_handle_t bus, const esp_lcd_panel_io_spi_config_t *io_config,
+                                   esp_lcd_panel_io_handle_t *ret_io)
+{
+    (void)bus;
+    if (!io_config || !ret_io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct esp_lcd_panel_io_t *io = calloc(1, sizeof(*io));
+    if (!io) {
+        return ESP_ERR_NO_MEM;
+    }
+    io->pclk_hz = io_config->pclk_hz;
+    io->on_color_trans_done = io_config->on_color_trans_done;
+    io->user_ctx = io_config->user_ctx;
+    *ret_io = io;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io,
+                                                    const esp_lcd_panel_io_callbacks_t *cbs, void *user_ctx)
+{
+    io->on_color_trans_done = cbs->on_color_trans_done;
+    io->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io)
+{
+    free(io);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    (void)io;
+    pthread_mutex_lock(&s_panel.lock);
+    if (lcd_cmd >= 0) {
+        model_command(&s_panel, lcd_cmd, param, param_size);
+    }
+    pthread_mutex_unlock(&s_panel.lock);
+
+    __atomic_fetch_add(&g_sim_metrics.spi_bytes, 1 + param_size, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_sim_metrics.spi_transactions, 1, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+// Queued transactions are applied synchronously, so the completion
+// callback fires before this returns, as it would with a zero-latency DMA.
+// Like the real driver, any command can be sent this way; only memory
+// writes carry pixels.
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    const bool pixels = lcd_cmd < 0 || lcd_cmd == CMD_RAMWR || lcd_cmd == CMD_RAMWRC;
+
+    pthread_mutex_lock(&s_panel.lock);
+    if (lcd_cmd == CMD_RAMWR) {
+        s_panel.cx = s_panel.xs;
+        s_panel.cy = s_panel.ys;
+    }
+    if (pixels) {
+        model_write_pixels(&s_panel, color, color_size);
+    } else {
+        model_command(&s_panel, lcd_cmd, color, color_size);
+    }
+    pthread_mutex_unlock(&s_panel.lock);
+
+    __atomic_fetch_add(&g_sim_metrics.spi_bytes, (lcd_cmd >= 0 ? 1 : 0) + color_size, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_sim_metrics.spi_transactions, 1, __ATOMIC_RELAXED);
+    if (pixels) {
+        sim_metrics_flush((uint32_t)(color_size / 2));
+    }
+
+    if (io->on_color_trans_done) {
+        io->on_color_trans_done(io, NULL, io->user_ctx);
+    }
+    return ESP_OK;
+}
+
+/* ---------------------------------------------------------- panel ops */
+
+esp_err_t esp_lcd_new_panel_st7789(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                   esp_lcd_panel_handle_t *ret_panel)
+{
+    if (!io || !panel_dev_config || !ret_panel || panel_dev_config->bits_per_pixel != 16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct esp_lcd_panel_t *panel = calloc(1, sizeof(*panel));
+    if (!panel) {
+        return ESP_ERR_NO_MEM;
+    }
+    panel->io = io;
+    *ret_panel = panel;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel)
+{
+    free(panel);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    panel->madctl = 0;
+    return esp_lcd_panel_io_tx_param(panel->io, CMD_SWRESET, NULL, 0);
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    const uint8_t colmod = 0x55;
+    esp_lcd_panel_io_tx_param(panel->io, CMD_SLPOUT, NULL, 0);
+    esp_lcd_panel_io_tx_param(panel->io, CMD_MADCTL, &panel->madctl, 1);
+    return esp_lcd_panel_io_tx_param(panel->io, CMD_COLMOD, &colmod, 1);
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start,
+                                    int x_end, int y_end, const void *color_data)
+{
+    const uint8_t caset[4] = {x_start >> 8, x_start & 0xff, (x_end - 1) >> 8, (x_end - 1) & 0xff};
+    const uint8_t raset[4] = {y_start >> 8, y_start & 0xff, (y_end - 1) >> 8, (y_end - 1) & 0xff};
+    esp_lcd_panel_io_tx_param(panel->io, CMD_CASET, caset, sizeof(caset));
+    esp_lcd_panel_io_tx_param(panel->io, CMD_RASET, raset, sizeof(raset));
+    size_t len = (size_t)(x_end - x_start) * (size_t)(y_end - y_start) * 2;
+    return esp_lcd_panel_io_tx_color(panel->io, CMD_RAMWR, color_data, len);
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    panel->madctl = (panel->madctl & ~(MADCTL_MX | MADCTL_MY)) |
+                    (mirror_x ? MADCTL_MX : 0) | (mirror_y ? MADCTL_MY : 0);
+    return esp_lcd_panel_io_tx_param(panel->io, CMD_MADCTL, &panel->madctl, 1);
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    panel->madctl = (panel->madctl & ~MADCTL_MV) | (swap_axes ? MADCTL_MV : 0);
+    return esp_lcd_panel_io_tx_param(panel->io, CMD_MADCTL, &panel->madctl, 1);
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    (void)panel;
+    return (x_gap == 0 && y_gap == 0) ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data)
+{
+    return esp_lcd_panel_io_tx_param(panel->io, invert_color_data ? CMD_INVON : CMD_INVOFF, NULL, 0);
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off)
+{
+    return esp_lcd_panel_io_tx_param(panel->io, on_off ? CMD_DISPON : CMD_DISPOFF, NULL, 0);
+}
+
+esp_err_t esp_lcd_panel_disp_sleep(esp_lcd_panel_handle_t panel, bool sleep)
+{
+    return esp_lcd_panel_io_tx_param(panel->io, sleep ? CMD_SLPIN : CMD_SLPOUT, NULL, 0);
+}
+
+/* ------------------------------------------------------------- output */
+
+// Write what the glass shows, in the current logical orientation
+bool sim_panel_dump_ppm(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+
+    pthread_mutex_lock(&s_panel.lock);
+    bool swapped = s_panel.madctl & MADCTL_MV;
+    int w = swapped ? PANEL_H : PANEL_W;
+    int h = swapped ? PANEL_W : PANEL_H;
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    for (int ly = 0; ly < h; ly++) {
+        for (int lx = 0; lx < w; lx++) {
+            int row, col;
+            model_map(&s_panel, lx, ly, &row, &col);
+            if (row >= s_panel.tfa && row < s_panel.tfa + s_panel.vsa) {
+                row = s_panel.tfa + (row - 2 * s_panel.tfa + s_panel.vsp + s_panel.vsa) % s_panel.vsa;
+            }
+            uint16_t px = s_panel.mem[row][col];
+            if (s_panel.inverted) {
+                px = ~px;
+            }
+            uint8_t rgb[3] = {
+                (uint8_t)(((px >> 11) & 0x1f) << 3),
+                (uint8_t)(((px >> 5) & 0x3f) << 2),
+                (uint8_t)((px & 0x1f) << 3),
+            };
+            if (s_panel.sleeping || !s_panel.display_on) {
+                rgb[0] = rgb[1] = rgb[2] = 0;
+            }
+            fwrite(rgb, 1, sizeof(rgb), f);
+        }
+    }
+    pthread_mutex_unlock(&s_panel.lock);
+
+    fclose(f);
+    return true;
+}
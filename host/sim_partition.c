@@ -0,0 +1,110 @@
+// Flash partition shim for the host build. The "samplelog" partition lives
+// in memory with NOR semantics (erase sets bytes to 0xFF, programming can
+// only clear bits) and is mirrored to a file when one is given, so a second
+// run starts from the history of the first.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_partition.h"
+#include "sim.h"
+
+#define SIM_PARTITION_ADDR 0x110000
+#define SIM_PARTITION_SIZE 0xF0000
+#define SIM_SECTOR_SIZE    4096
+
+static esp_partition_t s_part = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x40,
+    .address = SIM_PARTITION_ADDR,
+    .size = SIM_PARTITION_SIZE,
+    .erase_size = SIM_SECTOR_SIZE,
+    .label = "samplelog",
+};
+
+static uint8_t *s_image;
+static const char *s_path;
+static FILE *s_file;
+
+void sim_partition_set_file(const char *path)
+{
+    s_path = path;
+}
+
+static void image_load(void)
+{
+    s_image = malloc(SIM_PARTITION_SIZE);
+    memset(s_image, 0xFF, SIM_PARTITION_SIZE);
+    if (!s_path) {
+        return;
+    }
+    s_file = fopen(s_path, "r+b");
+    if (s_file) {
+        size_t n = fread(s_image, 1, SIM_PARTITION_SIZE, s_file);
+        (void)n;
+    } else {
+        s_file = fopen(s_path, "w+b");
+    }
+    if (!s_file) {
+        fprintf(stderr, "could not open %s\n", s_path);
+        return;
+    }
+    // Keep the file the full partition size so offsets line up
+    fseek(s_file, 0, SEEK_SET);
+    fwrite(s_image, 1, SIM_PARTITION_SIZE, s_file);
+    fflush(s_file);
+}
+
+static void image_sync(size_t offset, size_t size)
+{
+    if (!s_file) {
+        return;
+    }
+    fseek(s_file, (long)offset, SEEK_SET);
+    fwrite(&s_image[offset], 1, size, s_file);
+    fflush(s_file);
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (type != s_part.type || subtype != s_part.subtype || (label && strcmp(label, s_part.label))) {
+        return NULL;
+    }
+    if (!s_image) {
+        image_load();
+    }
+    return &s_part;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (partition != &s_part || src_offset + size > s_part.size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, &s_image[src_offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    if (partition != &s_part || dst_offset + size > s_part.size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t *bytes = src;
+    for (size_t i = 0; i < size; i++) {
+        s_image[dst_offset + i] &= bytes[i];
+    }
+    image_sync(dst_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (partition != &s_part || offset + size > s_part.size ||
+            offset % SIM_SECTOR_SIZE || size % SIM_SECTOR_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&s_image[offset], 0xFF, size);
+    image_sync(offset, size);
+    return ESP_OK;
+}
@@ -0,0 +1,637 @@
+// Virtual-clock FreeRTOS for the host build.
+//
+// Every task is a pthread, but only the task holding the run token executes;
+// it keeps it until it blocks or yields, then the next ready task (FIFO) runs.
+// When no task is ready the clock jumps straight to the earliest pending
+// timeout. Runs are therefore deterministic and need no wall time for delays.
+// Priorities are ignored and there is no preemption, so a woken task runs
+// once the current one blocks.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "sim.h"
+
+#define TICK_US (1000000 / configTICK_RATE_HZ)
+#define NO_TIMEOUT INT64_MAX
+
+struct sim_task {
+    pthread_t thread;
+    pthread_cond_t cond;
+    TaskFunction_t fn;
+    void *arg;
+    char name[16];
+    uint32_t stack_depth;
+    UBaseType_t priority;
+    uint64_t busy_ns;    // wall time holding the token
+    bool blocked;
+    bool woken;          // released by an object rather than by timeout
+    const void *wait_obj;
+    int64_t wake_us;
+    uint32_t notify;
+    struct sim_task *next;
+    struct sim_task *ready_next;
+};
+
+struct sim_sem {
+    UBaseType_t count;
+    UBaseType_t max;
+    bool recursive;
+    struct sim_task *owner;
+    UBaseType_t depth;
+};
+
+struct sim_queue {
+    uint8_t *buf;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_done = PTHREAD_COND_INITIALIZER;
+static struct sim_task *s_tasks = NULL;
+static struct sim_task *s_ready_head = NULL;
+static struct sim_task *s_ready_tail = NULL;
+static struct sim_task *s_current = NULL;
+static int64_t s_now_us = 0;
+static uint64_t s_busy_ns = 0;       // wall time with a task holding the token
+static uint64_t s_slice_start_ns = 0;
+static double s_cpu_scale = SIM_CPU_SCALE_DEFAULT;
+static int64_t s_end_us = 0;
+static bool s_finished = false;
+static __thread struct sim_task *t_self = NULL;
+
+void sim_rtos_init(int64_t duration_us)
+{
+    s_end_us = duration_us;
+}
+
+int64_t sim_now_us(void)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t now = s_now_us;
+    pthread_mutex_unlock(&s_lock);
+    return now;
+}
+
+uint64_t sim_wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void ready_push_locked(struct sim_task *t)
+{
+    t->ready_next = NULL;
+    if (s_ready_tail) {
+        s_ready_tail->ready_next = t;
+    } else {
+        s_ready_head = t;
+    }
+    s_ready_tail = t;
+}
+
+// Move the clock to the earliest timeout and make those tasks ready.
+// Returns false once the simulated duration is over.
+static bool advance_locked(void)
+{
+    int64_t next = NO_TIMEOUT;
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->blocked && t->wake_us < next) {
+            next = t->wake_us;
+        }
+    }
+
+    if (next == NO_TIMEOUT) {
+        fprintf(stderr, "sim: all tasks blocked forever at %lld us\n", (long long)s_now_us);
+        abort();
+    }
+
+    if (next > s_end_us) {
+        // Leave every task parked; the main thread reports and exits
+        s_now_us = s_end_us;
+        s_finished = true;
+        pthread_cond_broadcast(&s_done);
+        return false;
+    }
+
+    s_now_us = next;
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->blocked && t->wake_us <= s_now_us) {
+            t->blocked = false;
+            t->woken = false;
+            ready_push_locked(t);
+        }
+    }
+    return true;
+}
+
+// Hand the run token to the next ready task
+static void dispatch_locked(void)
+{
+    if (s_current) {
+        const uint64_t slice_ns = sim_wall_ns() - s_slice_start_ns;
+        s_busy_ns += slice_ns;
+        s_current->busy_ns += slice_ns;
+    }
+    s_current = NULL;
+    while (!s_ready_head) {
+        if (!advance_locked()) {
+            return;
+        }
+    }
+    s_current = s_ready_head;
+    s_slice_start_ns = sim_wall_ns();
+    s_ready_head = s_current->ready_next;
+    if (!s_ready_head) {
+        s_ready_tail = NULL;
+    }
+    pthread_cond_signal(&s_current->cond);
+}
+
+static void wait_turn_locked(struct sim_task *self)
+{
+    while (s_current != self) {
+        pthread_cond_wait(&self->cond, &s_lock);
+    }
+}
+
+void sim_rtos_start(void)
+{
+    pthread_mutex_lock(&s_lock);
+    dispatch_locked();
+    while (!s_finished) {
+        pthread_cond_wait(&s_done, &s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+// Block the calling task until woken through wait_obj or until wake_us.
+// Returns true when released by the object.
+static bool block_locked(const void *wait_obj, int64_t wake_us)
+{
+    struct sim_task *self = t_self;
+    if (!self) {
+        fprintf(stderr, "sim: blocking call outside a task\n");
+        abort();
+    }
+
+    self->blocked = true;
+    self->woken = false;
+    self->wait_obj = wait_obj;
+    self->wake_us = wake_us;
+    dispatch_locked();
+    wait_turn_locked(self);
+    self->wait_obj = NULL;
+    return self->woken;
+}
+
+// Make one task blocked on obj ready, if any
+static void wake_one_locked(const void *obj)
+{
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        if (t->blocked && t->wait_obj == obj) {
+            t->blocked = false;
+            t->woken = true;
+            ready_push_locked(t);
+            return;
+        }
+    }
+}
+
+static int64_t deadline_locked(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return NO_TIMEOUT;
+    }
+    return s_now_us + (int64_t)ticks * TICK_US;
+}
+
+/* ---------------------------------------------------------------- tasks */
+
+static void *task_entry(void *arg)
+{
+    struct sim_task *self = arg;
+    t_self = self;
+    pthread_mutex_lock(&s_lock);
+    wait_turn_locked(self);
+    pthread_mutex_unlock(&s_lock);
+    self->fn(self->arg);
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id)
+{
+    (void)core_id;
+
+    struct sim_task *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->stack_depth = stack_depth;
+    t->priority = priority;
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "");
+    pthread_cond_init(&t->cond, NULL);
+
+    pthread_mutex_lock(&s_lock);
+    t->next = s_tasks;
+    s_tasks = t;
+    ready_push_locked(t);
+    pthread_mutex_unlock(&s_lock);
+
+    if (pthread_create(&t->thread, NULL, task_entry, t) != 0) {
+        abort();
+    }
+    pthread_detach(t->thread);
+
+    if (handle) {
+        *handle = t;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task && task != t_self) {
+        fprintf(stderr, "sim: deleting another task is not supported\n");
+        abort();
+    }
+
+    pthread_mutex_lock(&s_lock);
+    struct sim_task **pp = &s_tasks;
+    while (*pp && *pp != t_self) {
+        pp = &(*pp)->next;
+    }
+    if (*pp) {
+        *pp = t_self->next;
+    }
+    dispatch_locked();
+    pthread_mutex_unlock(&s_lock);
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    if (ticks == 0) {
+        ready_push_locked(t_self);
+        dispatch_locked();
+        wait_turn_locked(t_self);
+    } else {
+        block_locked(NULL, deadline_locked(ticks));
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *prev_wake, TickType_t increment)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t wake = ((int64_t)*prev_wake + increment) * TICK_US;
+    *prev_wake += increment;
+    bool delayed = wake > s_now_us;
+    if (delayed) {
+        block_locked(NULL, wake);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return delayed ? pdTRUE : pdFALSE;
+}
+
+void sim_rtos_set_cpu_scale(double scale)
+{
+    s_cpu_scale = scale;
+}
+
+// Virtual time not spent running tasks. Task code takes no virtual time,
+// so its wall time, scaled to the target CPU, stands in for it.
+configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimeCounter(void)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t busy_us = (int64_t)(s_busy_ns * s_cpu_scale / 1000.0);
+    int64_t idle_us = s_now_us > busy_us ? s_now_us - busy_us : 0;
+    pthread_mutex_unlock(&s_lock);
+    return (configRUN_TIME_COUNTER_TYPE)idle_us;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    UBaseType_t n = 0;
+
+    pthread_mutex_lock(&s_lock);
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        n++;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+// Host pthread stacks say nothing about the target, so the stack
+// high-water mark is reported as the whole configured depth
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, configRUN_TIME_COUNTER_TYPE *total_run_time)
+{
+    UBaseType_t n = 0;
+
+    pthread_mutex_lock(&s_lock);
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        n++;
+    }
+    if (n > size) {
+        pthread_mutex_unlock(&s_lock);
+        return 0;
+    }
+    n = 0;
+    for (struct sim_task *t = s_tasks; t; t = t->next) {
+        uint64_t busy_ns = t->busy_ns;
+        if (t == s_current) {
+            busy_ns += sim_wall_ns() - s_slice_start_ns;
+        }
+        status[n++] = (TaskStatus_t){
+            .xHandle = t,
+            .pcTaskName = t->name,
+            .uxCurrentPriority = t->priority,
+            .ulRunTimeCounter = (configRUN_TIME_COUNTER_TYPE)(busy_ns * s_cpu_scale / 1000.0),
+            .usStackHighWaterMark = t->stack_depth,
+        };
+    }
+    if (total_run_time) {
+        *total_run_time = (configRUN_TIME_COUNTER_TYPE)s_now_us;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    return (esp_cpu_cycle_count_t)(uint64_t)(sim_wall_ns() * s_cpu_scale * SIM_CPU_MHZ / 1000.0);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_now_us() / TICK_US);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return t_self;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    task = task ? task : t_self;
+    return task ? task->name : "main";
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&s_lock);
+    task->notify++;
+    if (task->blocked && task->wait_obj == &task->notify) {
+        wake_one_locked(&task->notify);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_prio_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_prio_woken) {
+        *higher_prio_woken = pdFALSE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    struct sim_task *self = t_self;
+    int64_t deadline = deadline_locked(ticks);
+    while (self->notify == 0 && ticks != 0 && s_now_us < deadline) {
+        block_locked(&self->notify, deadline);
+    }
+    uint32_t value = self->notify;
+    if (value) {
+        self->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return value;
+}
+
+/* ----------------------------------------------------------- semaphores */
+
+static SemaphoreHandle_t sem_create(UBaseType_t max, UBaseType_t initial, bool recursive)
+{
+    struct sim_sem *sem = calloc(1, sizeof(*sem));
+    if (sem) {
+        sem->max = max;
+        sem->count = initial;
+        sem->recursive = recursive;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return sem_create(1, 1, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return sem_create(1, 1, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return sem_create(1, 0, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return sem_create(max, initial, false);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t deadline = deadline_locked(ticks);
+    while (sem->count == 0) {
+        if (ticks == 0 || s_now_us >= deadline) {
+            pthread_mutex_unlock(&s_lock);
+            return pdFALSE;
+        }
+        block_locked(sem, deadline);
+    }
+    sem->count--;
+    sem->owner = t_self;
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&s_lock);
+    if (sem->count >= sem->max) {
+        pthread_mutex_unlock(&s_lock);
+        return pdFALSE;
+    }
+    sem->count++;
+    sem->owner = NULL;
+    wake_one_locked(sem);
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken)
+{
+    if (higher_prio_woken) {
+        *higher_prio_woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    if (sem->owner == t_self && sem->depth > 0) {
+        sem->depth++;
+        pthread_mutex_unlock(&s_lock);
+        return pdTRUE;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (xSemaphoreTake(sem, ticks) != pdTRUE) {
+        return pdFALSE;
+    }
+    pthread_mutex_lock(&s_lock);
+    sem->depth = 1;
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&s_lock);
+    if (sem->owner != t_self || sem->depth == 0) {
+        pthread_mutex_unlock(&s_lock);
+        return pdFALSE;
+    }
+    bool release = --sem->depth == 0;
+    pthread_mutex_unlock(&s_lock);
+    return release ? xSemaphoreGive(sem) : pdTRUE;
+}
+
+/* --------------------------------------------------------------- queues */
+
+// Senders wait on the queue itself, receivers on the item buffer
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *q = calloc(1, sizeof(*q));
+    if (!q) {
+        return NULL;
+    }
+    q->buf = calloc(length, item_size);
+    if (!q->buf) {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    free(queue->buf);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t deadline = deadline_locked(ticks);
+    while (q->count == q->length) {
+        if (ticks == 0 || s_now_us >= deadline) {
+            pthread_mutex_unlock(&s_lock);
+            return pdFALSE;
+        }
+        block_locked(q, deadline);
+    }
+    UBaseType_t tail = (q->head + q->count) % q->length;
+    memcpy(q->buf + (size_t)tail * q->item_size, item, q->item_size);
+    q->count++;
+    wake_one_locked(q->buf);
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *higher_prio_woken)
+{
+    if (higher_prio_woken) {
+        *higher_prio_woken = pdFALSE;
+    }
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t deadline = deadline_locked(ticks);
+    while (q->count == 0) {
+        if (ticks == 0 || s_now_us >= deadline) {
+            pthread_mutex_unlock(&s_lock);
+            return pdFALSE;
+        }
+        block_locked(q->buf, deadline);
+    }
+    memcpy(item, q->buf + (size_t)q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    wake_one_locked(q);
+    pthread_mutex_unlock(&s_lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *higher_prio_woken)
+{
+    if (higher_prio_woken) {
+        *higher_prio_woken = pdFALSE;
+    }
+    return xQueueReceive(q, item, 0);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&s_lock);
+    UBaseType_t count = q->count;
+    pthread_mutex_unlock(&s_lock);
+    return count;
+}
@@ -0,0 +1,240 @@
+// Simulated SCD41 on the i2c_master API, modelled at the command level:
+// start/stop periodic measurement (standard or low-power), data-ready
+// status and read_measurement, with CRC-protected response words and NACKs
+// where the real sensor gives them (busy executing a command, nothing to
+// read). Measurement k becomes ready at start + k periods of the sensor's
+// own clock, which runs slightly slow so a reader pacing itself on the
+// host clock drifts against it. Values follow a slow daily cycle plus
+// seeded noise so runs are reproducible.
+#include <math.h>
+#include <string.h>
+#include "driver/i2c_master.h"
+#include "sim.h"
+
+#define SCD41_I2C_ADDR 0x62
+#define SCD41_CMD_START_PERIODIC 0x21B1
+#define SCD41_CMD_START_LOW_POWER_PERIODIC 0x21AC
+#define SCD41_CMD_STOP_PERIODIC 0x3F86
+#define SCD41_CMD_GET_DATA_READY 0xE4B8
+#define SCD41_CMD_READ_MEASUREMENT 0xEC05
+#define SCD41_PERIOD_US 5000000LL
+#define SCD41_LOW_POWER_PERIOD_US 30000000LL
+#define SCD41_CLOCK_PPM 2000            // sensor period is this much longer
+#define SCD41_CMD_EXEC_US 1000
+#define SCD41_STOP_EXEC_US 500000
+
+struct i2c_master_bus_t {
+    int port;
+};
+
+struct i2c_master_dev_t {
+    uint16_t addr;
+    i2c_master_event_callbacks_t cbs;
+    void *user_data;
+};
+
+static struct i2c_master_bus_t s_bus;
+static struct i2c_master_dev_t s_dev;
+
+static uint32_t s_rng = 1;
+static int64_t s_started_us = -1;
+static int64_t s_period_us = SCD41_PERIOD_US;
+static int64_t s_last_read = 0;         // index of the last measurement read
+static int64_t s_busy_until_us = 0;
+static uint8_t s_response[9];
+static size_t s_response_len = 0;       // 0: nothing to read
+
+void sim_scd41_seed(uint32_t seed)
+{
+    s_rng = seed ? seed : 1;
+}
+
+// Uniform noise in [-1, 1)
+static float noise(void)
+{
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return (float)(s_rng >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+static uint8_t crc8(const uint8_t *data)
+{
+    uint8_t crc = 0xFF;
+
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void respond(const uint16_t *words, int count)
+{
+    for (int i = 0; i < count; i++) {
+        uint8_t *w = &s_response[i * 3];
+        w[0] = words[i] >> 8;
+        w[1] = words[i] & 0xff;
+        w[2] = crc8(w);
+    }
+    s_response_len = (size_t)count * 3;
+}
+
+// Index of the newest finished measurement, 0 before the first
+static int64_t latest_measurement(int64_t now)
+{
+    if (s_started_us < 0) {
+        return 0;
+    }
+    return (now - s_started_us) / s_period_us;
+}
+
+static int64_t measurement_ready_us(int64_t k)
+{
+    return s_started_us + k * s_period_us;
+}
+
+static void start_periodic(int64_t now, int64_t nominal_period_us)
+{
+    s_started_us = now;
+    s_period_us = nominal_period_us + nominal_period_us / 1000000 * SCD41_CLOCK_PPM;
+    s_last_read = 0;
+}
+
+static bool read_measurement(int64_t now)
+{
+    const int64_t k = latest_measurement(now);
+    if (k <= s_last_read) {
+        return false;
+    }
+    sim_metrics_sensor_read(measurement_ready_us(k), (uint32_t)(k - s_last_read - 1));
+    s_last_read = k;
+
+    double day = (double)now / (24.0 * 3600.0 * 1e6) * 2.0 * M_PI;
+    const float temperature = 22.5f + 2.5f * (float)sin(day) + 0.1f * noise();
+    const float humidity = 45.0f - 8.0f * (float)sin(day) + 0.3f * noise();
+    const uint16_t words[3] = {
+        (uint16_t)(700.0 + 300.0 * sin(day * 3.0) + 15.0 * noise()),
+        (uint16_t)lroundf((temperature + 45.0f) * 65535.0f / 175.0f),
+        (uint16_t)lroundf(humidity * 65535.0f / 100.0f),
+    };
+    respond(words, 3);
+    sim_metrics_sample_ready();
+    return true;
+}
+
+// One write transfer; false is a NACK
+static bool scd41_write(const uint8_t *buf, size_t len)
+{
+    const int64_t now = sim_now_us();
+
+    if (len < 2 || now < s_busy_until_us) {
+        return false;
+    }
+    s_response_len = 0;
+    s_busy_until_us = now + SCD41_CMD_EXEC_US;
+
+    switch ((buf[0] << 8) | buf[1]) {
+        case SCD41_CMD_START_PERIODIC:
+        case SCD41_CMD_START_LOW_POWER_PERIODIC:
+            if (s_started_us >= 0) {
+                return false;
+            }
+            start_periodic(now, buf[1] == (SCD41_CMD_START_PERIODIC & 0xff) ? SCD41_PERIOD_US
+                                                                           : SCD41_LOW_POWER_PERIOD_US);
+            return true;
+        case SCD41_CMD_STOP_PERIODIC:
+            s_started_us = -1;
+            s_busy_until_us = now + SCD41_STOP_EXEC_US;
+            return true;
+        case SCD41_CMD_GET_DATA_READY: {
+            // Lower 11 bits non-zero when a measurement is waiting
+            const uint16_t status = latest_measurement(now) > s_last_read ? 0x8006 : 0x8000;
+            respond(&status, 1);
+            return true;
+        }
+        case SCD41_CMD_READ_MEASUREMENT:
+            // Nothing to read makes the following read NACK
+            read_measurement(now);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// One read transfer; false is a NACK
+static bool scd41_read(uint8_t *buf, size_t len)
+{
+    if (sim_now_us() < s_busy_until_us || s_response_len == 0 || len > s_response_len) {
+        return false;
+    }
+    memcpy(buf, s_response, len);
+    s_response_len = 0;
+    return true;
+}
+
+/* ----------------------------------------------------------- i2c_master */
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle)
+{
+    if (!bus_config || !ret_bus_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_bus.port = bus_config->i2c_port;
+    *ret_bus_handle = &s_bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config,
+                                    i2c_master_dev_handle_t *ret_handle)
+{
+    if (!bus_handle || !dev_config || !ret_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_dev.addr = dev_config->device_address;
+    *ret_handle = &s_dev;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_register_event_callbacks(i2c_master_dev_handle_t i2c_dev,
+                                              const i2c_master_event_callbacks_t *cbs, void *user_data)
+{
+    if (!i2c_dev || !cbs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    i2c_dev->cbs = *cbs;
+    i2c_dev->user_data = user_data;
+    return ESP_OK;
+}
+
+static esp_err_t complete(i2c_master_dev_handle_t i2c_dev, bool acked)
+{
+    if (i2c_dev->cbs.on_trans_done) {
+        const i2c_master_event_data_t evt = {
+            .event = acked ? I2C_EVENT_DONE : I2C_EVENT_NACK,
+        };
+        i2c_dev->cbs.on_trans_done(i2c_dev, &evt, i2c_dev->user_data);
+        return ESP_OK;
+    }
+    return acked ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+                              int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    if (!i2c_dev || !write_buffer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return complete(i2c_dev, i2c_dev->addr == SCD41_I2C_ADDR && scd41_write(write_buffer, write_size));
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size,
+                             int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    if (!i2c_dev || !read_buffer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return complete(i2c_dev, i2c_dev->addr == SCD41_I2C_ADDR && scd41_read(read_buffer, read_size));
+}
@@ -0,0 +1,108 @@
+// Stress run for the sensor snapshot seqlock on real threads, outside the
+// virtual clock: one writer publishes back to back while several readers
+// check that every copy they get is internally consistent.
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "sensor_snapshot.h"
+#include "sim.h"
+
+#define STRESS_READERS 4
+
+static sensor_snapshot_cell_t s_cell;
+static atomic_bool s_stop;
+
+typedef struct {
+    uint64_t reads;
+    uint64_t failed;        // gave up after SENSOR_SNAPSHOT_READ_TRIES
+    uint64_t torn;
+    uint64_t backwards;     // count went down between two reads
+} reader_stats_t;
+
+// Every field is derived from the count, so a mix of two publishes shows
+static void snapshot_fill(sensor_snapshot_t *snap, uint32_t n)
+{
+    snap->count = n;
+    snap->time_s = n * 5;
+    snap->latest = (ts_point_t) {(int16_t)n, (uint16_t)(n * 3), (uint16_t)(n * 7)};
+    snap->min = (ts_point_t) {(int16_t)(n - 1), (uint16_t)(n * 3 - 1), (uint16_t)(n * 7 - 1)};
+    snap->max = (ts_point_t) {(int16_t)(n + 1), (uint16_t)(n * 3 + 1), (uint16_t)(n * 7 + 1)};
+    snap->reserved = (uint16_t)~n;
+}
+
+static void *writer_thread(void *arg)
+{
+    uint64_t *max_ns = arg;
+    sensor_snapshot_t snap;
+
+    for (uint32_t n = 1; !atomic_load(&s_stop); n++) {
+        snapshot_fill(&snap, n);
+        uint64_t start = sim_wall_ns();
+        sensor_snapshot_publish(&s_cell, &snap);
+        uint64_t ns = sim_wall_ns() - start;
+        if (ns > *max_ns) {
+            *max_ns = ns;
+        }
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg)
+{
+    reader_stats_t *stats = arg;
+    sensor_snapshot_t snap, expect;
+    uint32_t last = 0;
+
+    while (!atomic_load(&s_stop)) {
+        if (!sensor_snapshot_read(&s_cell, &snap)) {
+            stats->failed++;
+            continue;
+        }
+        stats->reads++;
+        snapshot_fill(&expect, snap.count);
+        if (memcmp(&snap, &expect, sizeof(snap)) != 0) {
+            stats->torn++;
+        }
+        if (snap.count < last) {
+            stats->backwards++;
+        }
+        last = snap.count;
+    }
+    return NULL;
+}
+
+int sim_stress_snapshot(double seconds)
+{
+    pthread_t writer, readers[STRESS_READERS];
+    reader_stats_t stats[STRESS_READERS] = {0};
+    uint64_t writer_max_ns = 0;
+
+    sensor_snapshot_init(&s_cell);
+    atomic_store(&s_stop, false);
+    pthread_create(&writer, NULL, writer_thread, &writer_max_ns);
+    for (int i = 0; i < STRESS_READERS; i++) {
+        pthread_create(&readers[i], NULL, reader_thread, &stats[i]);
+    }
+
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+    atomic_store(&s_stop, true);
+
+    pthread_join(writer, NULL);
+    reader_stats_t total = {0};
+    for (int i = 0; i < STRESS_READERS; i++) {
+        pthread_join(readers[i], NULL);
+        total.reads += stats[i].reads;
+        total.failed += stats[i].failed;
+        total.torn += stats[i].torn;
+        total.backwards += stats[i].backwards;
+    }
+
+    printf("snapshot_readers=%d reads=%llu failed=%llu torn=%llu backwards=%llu writer_max_ns=%llu\n",
+           STRESS_READERS, (unsigned long long)total.reads, (unsigned long long)total.failed,
+           (unsigned long long)total.torn, (unsigned long long)total.backwards,
+           (unsigned long long)writer_max_ns);
+    return total.torn || total.backwards ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// esp_timer for the host build: timers live in a list scanned by one
+// simulated task that sleeps until the earliest deadline, like the real
+// esp_timer task. Callbacks may start and stop timers, including their own.
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "sim.h"
+
+#define NOT_ARMED INT64_MAX
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    int64_t deadline_us;
+    uint64_t period_us;     // 0 for one-shot
+    struct esp_timer *next;
+};
+
+static struct esp_timer *s_timers = NULL;
+static TaskHandle_t s_timer_task = NULL;
+
+static void timer_task(void *arg)
+{
+    (void)arg;
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        struct esp_timer *due = NULL;
+        int64_t next = NOT_ARMED;
+
+        for (struct esp_timer *t = s_timers; t; t = t->next) {
+            if (t->deadline_us <= now) {
+                due = t;
+                break;
+            }
+            if (t->deadline_us < next) {
+                next = t->deadline_us;
+            }
+        }
+
+        if (due) {
+            if (due->period_us) {
+                due->deadline_us += due->period_us;
+            } else {
+                due->deadline_us = NOT_ARMED;
+            }
+            due->callback(due->arg);
+            continue;
+        }
+
+        TickType_t ticks = portMAX_DELAY;
+        if (next != NOT_ARMED) {
+            int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+            ticks = (TickType_t)((next - now + tick_us - 1) / tick_us);
+        }
+        ulTaskNotifyTake(pdTRUE, ticks);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct esp_timer *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->callback = create_args->callback;
+    t->arg = create_args->arg;
+    t->deadline_us = NOT_ARMED;
+    t->next = s_timers;
+    s_timers = t;
+
+    if (!s_timer_task) {
+        xTaskCreate(timer_task, "esp_timer", 4096, NULL, 22, &s_timer_task);
+    }
+    *out_handle = t;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t t, uint64_t timeout_us, uint64_t period_us)
+{
+    if (!t) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (t->deadline_us != NOT_ARMED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    t->deadline_us = esp_timer_get_time() + (int64_t)timeout_us;
+    t->period_us = period_us;
+    xTaskNotifyGive(s_timer_task);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->deadline_us == NOT_ARMED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->deadline_us = NOT_ARMED;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (struct esp_timer **pp = &s_timers; *pp; pp = &(*pp)->next) {
+        if (*pp == timer) {
+            *pp = timer->next;
+            free(timer);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer && timer->deadline_us != NOT_ARMED;
+}
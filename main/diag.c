@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "perf.h"
+#include "st7789.h"
+#include "ui_theme.h"
+#include "diag.h"
+
+static const char *TAG = "DIAG";
+
+#define DIAG_SCREEN_TASKS       6
+
+// Counters as of the previous report, one set per reader
+typedef struct {
+    int64_t time_us;
+    uint64_t spi_bytes;
+    perf_tasks_t tasks;
+} diag_window_t;
+
+typedef struct {
+    uint32_t spi_kbps;              // kB/s since the previous report
+    uint32_t heap_used;
+    uint32_t heap_max_used;
+    uint8_t heap_frag_pct;
+} diag_totals_t;
+
+static lv_obj_t *screen_diag = NULL;
+static lv_obj_t *label_body = NULL;
+static lv_timer_t *refresh_timer = NULL;
+static diag_window_t screen_window;
+static diag_window_t log_window;
+static char body_text[1024];
+
+static void diag_collect(diag_window_t *win, diag_totals_t *totals)
+{
+    const int64_t now = esp_timer_get_time();
+    st7789_flush_stats_t fl;
+    lv_mem_monitor_t mon;
+
+    st7789_get_flush_stats(&fl);
+    totals->spi_kbps = now > win->time_us ? (uint32_t)((fl.bytes - win->spi_bytes) * 1000 / (now - win->time_us)) : 0;
+    win->time_us = now;
+    win->spi_bytes = fl.bytes;
+
+    lv_mem_monitor(&mon);
+    totals->heap_used = mon.total_size - mon.free_size;
+    totals->heap_max_used = mon.max_used;
+    totals->heap_frag_pct = mon.frag_pct;
+
+    perf_tasks_sample(&win->tasks);
+}
+
+static void diag_refresh_cb(lv_timer_t *timer)
+{
+    diag_totals_t totals;
+    int len = 0;
+
+    diag_collect(&screen_window, &totals);
+
+    len += snprintf(body_text + len, sizeof(body_text) - len, "us        avg    p95    max\n");
+    for (int i = 0; i < perf_hist_count() && len < (int)sizeof(body_text); i++) {
+        const perf_hist_t *h = perf_hist_get(i);
+        len += snprintf(body_text + len, sizeof(body_text) - len, "%-10s %6u %6u %6u\n", h->name,
+                        h->count ? (unsigned)(h->total_us / h->count) : 0,
+                        (unsigned)perf_hist_percentile(h, 95), (unsigned)h->max_us);
+    }
+    if (len < (int)sizeof(body_text)) {
+        len += snprintf(body_text + len, sizeof(body_text) - len,
+                        "SPI %u kB/s  heap %u B (max %u) frag %u%%\n", (unsigned)totals.spi_kbps,
+                        (unsigned)totals.heap_used, (unsigned)totals.heap_max_used, totals.heap_frag_pct);
+    }
+    for (int i = 0; i < screen_window.tasks.count && i < DIAG_SCREEN_TASKS && len < (int)sizeof(body_text); i++) {
+        const perf_task_t *t = &screen_window.tasks.tasks[i];
+        len += snprintf(body_text + len, sizeof(body_text) - len, "%-12s %3u.%u%%  stack %u\n", t->name,
+                        t->cpu_permille / 10, t->cpu_permille % 10, (unsigned)t->stack_free);
+    }
+    lv_label_set_text(label_body, body_text);
+}
+
+static void diag_log_cb(lv_timer_t *timer)
+{
+    diag_totals_t totals;
+    char line[128];
+
+    diag_collect(&log_window, &totals);
+
+    for (int i = 0; i < perf_hist_count(); i++) {
+        perf_format_hist(perf_hist_get(i), line, sizeof(line));
+        ESP_LOGI(TAG, "%s", line);
+    }
+    ESP_LOGI(TAG, "spi=%u kB/s heap_used=%u heap_max_used=%u heap_frag=%u%%", (unsigned)totals.spi_kbps,
+             (unsigned)totals.heap_used, (unsigned)totals.heap_max_used, totals.heap_frag_pct);
+    for (int i = 0; i < log_window.tasks.count; i++) {
+        perf_format_task(&log_window.tasks.tasks[i], line, sizeof(line));
+        ESP_LOGI(TAG, "%s", line);
+    }
+}
+
+static void diag_screen_delete_cb(lv_event_t *e)
+{
+    lv_timer_delete(refresh_timer);
+    refresh_timer = NULL;
+    label_body = NULL;
+    screen_diag = NULL;
+}
+
+void diag_init(void)
+{
+    // Both windows start now, so the first report covers the time since boot
+    screen_window.time_us = log_window.time_us = esp_timer_get_time();
+    lv_timer_create(diag_log_cb, DIAG_LOG_PERIOD_MS, NULL);
+}
+
+lv_obj_t *diag_screen_create(void)
+{
+    const ui_theme_t *th = ui_theme_get();
+
+    screen_diag = lv_obj_create(NULL);
+    ui_theme_apply(screen_diag, th->screen, 0);
+
+    lv_obj_t *label_title = lv_label_create(screen_diag);
+    lv_label_set_text(label_title, "Diagnostics");
+    ui_theme_apply(label_title, th->text, 0);
+    lv_obj_set_pos(label_title, 10, 5);
+
+    label_body = lv_label_create(screen_diag);
+    lv_label_set_text(label_body, "");
+    ui_theme_apply(label_body, th->text_dim, 0);
+    lv_obj_set_pos(label_body, 10, 28);
+
+    refresh_timer = lv_timer_create(diag_refresh_cb, DIAG_REFRESH_MS, NULL);
+    lv_timer_pause(refresh_timer);
+    lv_obj_add_event_cb(screen_diag, diag_screen_delete_cb, LV_EVENT_DELETE, NULL);
+    return screen_diag;
+}
+
+void diag_screen_set_visible(bool visible)
+{
+    if (refresh_timer == NULL) {
+        return;
+    }
+    if (visible) {
+        lv_timer_resume(refresh_timer);
+        lv_timer_ready(refresh_timer);
+    } else {
+        lv_timer_pause(refresh_timer);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdbool.h>
+#include "lvgl.h"
+
+// Diagnostics: a screen showing the perf histograms, SPI throughput, LVGL
+// heap and per-task CPU/stack, and the same data logged on the console
+// every DIAG_LOG_PERIOD_MS. Everything runs in the LVGL task.
+
+#define DIAG_LOG_PERIOD_MS      60000
+#define DIAG_REFRESH_MS         1000
+
+// Starts the console report. Call with the LVGL lock held.
+void diag_init(void);
+
+// Call with the LVGL lock held. The screen can be deleted at any time and
+// created again.
+lv_obj_t *diag_screen_create(void);
+
+// The screen, if it exists, is refreshed only while it is shown. Call
+// with the LVGL lock held.
+void diag_screen_set_visible(bool visible);
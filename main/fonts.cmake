@@ -0,0 +1,20 @@
+# font_subset(<name> <ttf> <size> <filter> <symbols> <opts> <sources...>)
+#
+# Generates <name>.c in the build directory with tools/font_subset.py from
+# the glyphs used by string literals in <sources>, adds it to the component
+# and prints the size report. <filter> is all, ascii or non-ascii; <opts>
+# is a list of extra script options such as --bpp 2 --compress.
+function(font_subset name ttf size filter symbols opts)
+    set(out "${CMAKE_CURRENT_BINARY_DIR}/${name}.c")
+    set(script "${PROJECT_DIR}/tools/font_subset.py")
+    idf_build_get_property(python PYTHON)
+
+    add_custom_command(OUTPUT ${out}
+        COMMAND ${python} ${script} --name ${name} --font ${ttf} --size ${size}
+                --filter ${filter} --symbols "${symbols}" ${opts} --scan ${ARGN} --out ${out}
+        DEPENDS ${script} ${ttf} ${ARGN}
+        COMMENT "Generating subset font ${name}"
+        VERBATIM)
+    target_sources(${COMPONENT_LIB} PRIVATE ${out})
+    set_property(DIRECTORY "${COMPONENT_DIR}" APPEND PROPERTY ADDITIONAL_CLEAN_FILES ${out})
+endfunction()
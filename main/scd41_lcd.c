@@ -1,5 +1,6 @@
-#include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
@@ -8,230 +9,718 @@
 #include "esp_err.h"
 #include "esp_timer.h"
 #include "esp_task_wdt.h"
+#include "lvgl_sched.h"
 #include "st7789.h"
-#include "scd41.h"
-#include "driver/i2c.h"
+#include "scd41_async.h"
+#include "window_extrema.h"
+#include "sample_store.h"
+#include "sample_log.h"
+#include "sensor_snapshot.h"
+#include "ui_queue.h"
+#include "power.h"
+#include "input.h"
+#include "perf.h"
+#include "diag.h"
+#include "ui_theme.h"
+#include "strip_chart.h"
+#include "screen_registry.h"
+#include "value_format.h"
+#include "digit_atlas.h"
 
 // SCD41 I2C config
 #define I2C_MASTER_SCL_IO 22
 #define I2C_MASTER_SDA_IO 21
-#define I2C_MASTER_FREQ_HZ 100000
+#define I2C_MASTER_FREQ_HZ 400000
+
+// Build with SCD41_FIXED_SCHEDULE=1 to read once per period after the
+// previous read instead of polling for data-ready, as the old blocking
+// driver did; only useful to compare sample latency
+#ifndef SCD41_FIXED_SCHEDULE
+#define SCD41_FIXED_SCHEDULE 0
+#endif
+
+// The SCD41 runs in low-power periodic mode while the screen is off: one
+// sample every 30 s at ~3 mA instead of every 5 s at ~15 mA. Build with
+// LOW_POWER_MODE=1 to keep it there with the screen on too; the graphs
+// then span six hours of raw samples instead of one. In the default build
+// a stretch with the screen off is plotted at one sample per 5 s like the
+// rest, so it is compressed six times on the graphs' time axis.
+#ifndef LOW_POWER_MODE
+#define LOW_POWER_MODE 0
+#endif
+
+#if LOW_POWER_MODE
+#define SAMPLE_PERIOD_MS 30000
+#else
+#define SAMPLE_PERIOD_MS 5000
+#endif
+
+// No sample for this long is reported; it covers a switch to low-power
+// mode, which can go a whole low-power period without one
+#define SENSOR_TIMEOUT_MS (2 * SCD41_ASYNC_LP_PERIOD_MS)
+
+// Build with SENSOR_DIGIT_ATLAS=0 to draw the sensor screen readings as
+// font labels instead of copying glyph tiles rendered once at boot
+#ifndef SENSOR_DIGIT_ATLAS
+#define SENSOR_DIGIT_ATLAS 1
+#endif
+
+// Every character value_format() writes for the readings; spaces are
+// blank cells. Ten cells fit ": 1234 ppm".
+#define VALUE_ATLAS_CHARSET "0123456789.-:Cpm%"
+#define VALUE_ATLAS_CELLS 10
+
+// Estimated battery use is logged this often
+#define POWER_REPORT_PERIOD_S 3600
 
 // GPIO config
 #define ON_OFF_BUTTON GPIO_NUM_32
 #define NEXT_SCREEN_BUTTON GPIO_NUM_33
-#define DEBOUNCE_TIME_MS 50
+#define ON_OFF_DOUBLE_PRESS_MS 300
+
+// Indices into the input configuration
+enum {
+    BUTTON_ON_OFF,
+    BUTTON_NEXT,
+};
+
+#define SCREEN_ROTATION LV_DISP_ROT_270
+
+// Min/max window, in samples
+#define MINMAX_WINDOW_SAMPLES 12
+
+// Hour and day min/max, over closed 1-min and 15-min history buckets
+#define SPAN_HOUR_BUCKETS 60
+#define SPAN_DAY_BUCKETS 96
+
+// The graphs plot the raw history in place, all of it: an hour of 5 s
+// samples, six hours in low-power mode
+#define GRAPH_WINDOW_MIN (SAMPLE_STORE_RAW_SLOTS * SAMPLE_PERIOD_MS / 60000)
+
+// History replayed from flash at boot: what the 1-min tier holds. The
+// coarser tiers start over from it rather than decoding a week of flash.
+#define HISTORY_RESTORE_HOURS (SAMPLE_STORE_1MIN_SLOTS / 60)
+
+// 1: graphs are full-height strip charts that the panel scrolls in
+// hardware; a sample redraws the newly exposed columns. Min/max move
+// to a column on the right and the time axis becomes a grid line every
+// GRAPH_STRIP_GRID_EVERY samples, since anything in the band scrolls.
+#ifndef GRAPH_STRIP_CHART
+#define GRAPH_STRIP_CHART 0
+#endif
+#define GRAPH_STRIP_POINTS 22
+#define GRAPH_STRIP_STEP 10
+#define GRAPH_STRIP_GRID_EVERY 12
+
+// Screens are built on first use and the next one after each load; while
+// less than this much of the LVGL heap is free in one block, screens not
+// shown are deleted before another is built. 1 builds every screen at
+// boot and keeps them, as before the registry.
+#ifndef SCREEN_BUILD_ALL
+#define SCREEN_BUILD_ALL 0
+#endif
+#define SCREEN_HEAP_RESERVE (16 * 1024)
 
 static const char *TAG = "SCD41";
 
-scd41_data_t sensor_data = {0};
-static SemaphoreHandle_t data_mutex = NULL;
+static SemaphoreHandle_t history_mutex = NULL;
 
 static lv_obj_t *label_co2 = NULL;
 static lv_obj_t *label_temp = NULL;
 static lv_obj_t *label_humid = NULL;
 
-static lv_obj_t *label_max_temp_data = NULL;
-static lv_obj_t *label_min_temp_data = NULL;
+static lv_obj_t *screen_sensor = NULL;
 
-static lv_obj_t *label_max_hum_data = NULL;
-static lv_obj_t *label_min_hum_data = NULL;
+static int current_screen = 0;
+static bool screen_on = true;
+static int screen_rotation = SCREEN_ROTATION;
 
-static lv_obj_t *label_max_co2_data = NULL;
-static lv_obj_t *label_min_co2_data = NULL;
+// Interrupt time of the press behind the last screen switch, for latency
+// accounting: set by the input handler, picked up when the switch is
+// applied and reported once it has been rendered
+static atomic_llong input_edge_us;
+static int64_t switch_edge_us = 0;
+static window_extrema_t minmax_window;
+static sample_store_t history;  // ~39 KB, guarded by history_mutex
 
-static lv_obj_t *screen_sensor = NULL;
+// Min/max over a span of a history tier, fed with each bucket the tier
+// closes. Owned by scd_task once it runs, like minmax_window.
+typedef struct {
+    const char *name;
+    ts_tier_t tier;
+    uint32_t buckets;
+    uint32_t seen_head;         // tier head at the last feed
+    window_extrema_t window;
+} span_extrema_t;
 
-static lv_obj_t *screen_temp_graph = NULL;
-static lv_obj_t *temp_chart = NULL;
-static lv_chart_series_t *temp_series = NULL;
+static span_extrema_t spans[] = {
+    {.name = "hour", .tier = TS_TIER_1MIN, .buckets = SPAN_HOUR_BUCKETS},
+    {.name = "day", .tier = TS_TIER_15MIN, .buckets = SPAN_DAY_BUCKETS},
+};
 
-static lv_obj_t *screen_hum_graph = NULL;
-static lv_obj_t *hum_chart = NULL;
-static lv_chart_series_t *hum_series = NULL;
+#define SPAN_COUNT (int)(sizeof(spans) / sizeof(spans[0]))
 
-static lv_obj_t *screen_co2_graph = NULL;
-static lv_obj_t *co2_chart = NULL;
-static lv_chart_series_t *co2_series = NULL;
+// Latest sample and window extrema; written by scd_task only
+static sensor_snapshot_cell_t sensor_cell;
+static uint32_t ui_seen_count = 0;
+static lv_timer_t *ui_sample_retry = NULL;  // a snapshot read gave up
 
-static int current_screen = 0;
-static scd41_data_t data_buffer[12]; //data buffer
-static int data_buffer_index = 0;
+extern void create_sensor_co2(const lv_style_t *caption_style);
+extern void create_sensor_temp(const lv_style_t *caption_style);
+extern void create_sensor_hum(const lv_style_t *caption_style);
+
+// Values shown in labels, in display units: tenths for temperature and
+// humidity, ppm for CO2. Published by the sensor task under the LVGL lock.
+typedef enum {
+    UI_TEMP,
+    UI_HUM,
+    UI_CO2,
+    UI_TEMP_MIN,
+    UI_TEMP_MAX,
+    UI_HUM_MIN,
+    UI_HUM_MAX,
+    UI_CO2_MIN,
+    UI_CO2_MAX,
+    UI_VALUE_COUNT
+} ui_value_t;
+
+#define UI_VALUE_NONE INT32_MIN     // nothing published yet, keep "--"
+#define UI_QUEUE_DEPTH 16
+#define UI_SAMPLE_RETRY_MS 5
+
+typedef enum {
+    SCREEN_SENSOR,
+    SCREEN_TEMP,
+    SCREEN_HUM,
+    SCREEN_CO2,
+    SCREEN_DIAG,
+    SCREEN_COUNT
+} screen_id_t;
+
+#define GRAPH_COUNT 3
+
+// A graph screen and the widgets the UI updates, NULL while the screen
+// is not built
+typedef struct {
+    lv_obj_t *screen;
+    lv_obj_t *chart;
+    lv_chart_series_t *series;
+    lv_obj_t *label_max;
+    lv_obj_t *label_min;
+    int y_high_lim;
+    ts_channel_t channel;
+    ui_value_t value_min;
+    ui_value_t value_max;
+} graph_screen_t;
+
+static graph_screen_t graphs[GRAPH_COUNT] = {
+    {.y_high_lim = 40, .channel = TS_CH_TEMP, .value_min = UI_TEMP_MIN, .value_max = UI_TEMP_MAX},
+    {.y_high_lim = 100, .channel = TS_CH_HUM, .value_min = UI_HUM_MIN, .value_max = UI_HUM_MAX},
+    {.y_high_lim = 2000, .channel = TS_CH_CO2, .value_min = UI_CO2_MIN, .value_max = UI_CO2_MAX},
+};
+
+static const screen_desc_t screen_descs[SCREEN_COUNT];
+
+typedef struct {
+    const char *prefix;
+    const char *unit;
+    bool tenths;
+} ui_format_t;
 
-static float min_temp = 0.0f;
-static float max_temp = 0.0f;
-static int min_co2 = 0;
-static int max_co2 = 0;
-static float min_hum = 0.0f;
-static float max_hum = 0.0f;
+static const ui_format_t ui_formats[UI_VALUE_COUNT] = {
+    [UI_TEMP] = {": ", "C", true},
+    [UI_HUM] = {": ", "%", true},
+    [UI_CO2] = {": ", "ppm", false},
+    [UI_TEMP_MIN] = {" ", "C", true},
+    [UI_TEMP_MAX] = {" ", "C", true},
+    [UI_HUM_MIN] = {" ", "%", true},
+    [UI_HUM_MAX] = {" ", "%", true},
+    [UI_CO2_MIN] = {" ", "ppm", false},
+    [UI_CO2_MAX] = {" ", "ppm", false},
+};
 
-extern void create_sensor_labels();
-extern void create_sensor_co2(const lv_font_t *font_label, const lv_font_t *font_value);
-extern void create_sensor_temp(const lv_font_t *font_label, const lv_font_t *font_value);
-extern void create_sensor_hum(const lv_font_t *font_label, const lv_font_t *font_value);
+static lv_subject_t ui_values[UI_VALUE_COUNT];
+static char ui_texts[UI_VALUE_COUNT][VALUE_FORMAT_MAX];
+static lv_subject_t ui_sample_subject;     // points at ui_sample on each new sample
+static ts_point_t ui_sample;
+static perf_hist_t *ui_sample_hist = NULL;
 
-// LVGL timer callback - runs in LVGL context
-static void lvgl_update_timer_cb(lv_timer_t *timer)
+// Round centi-units to the tenths shown on screen
+static int32_t centi_to_tenths(int32_t centi)
 {
-    char text_buffer[64];
-    
-    // Take mutex to safely read sensor data
-    if (xSemaphoreTake(data_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        if (sensor_data.data_ready) {
-            if (label_co2) {
-                snprintf(text_buffer, sizeof(text_buffer), ": %d ppm", sensor_data.co2_ppm);
-                lv_label_set_text(label_co2, text_buffer);
-            }
-            
-            if (label_temp) {
-                snprintf(text_buffer, sizeof(text_buffer), ": %.1f C", sensor_data.temperature);
-                lv_label_set_text(label_temp, text_buffer);
-            }
-            
-            if (label_humid) {
-                snprintf(text_buffer, sizeof(text_buffer), ": %.1f %%", sensor_data.humidity);
-                lv_label_set_text(label_humid, text_buffer);
-            }
+    return (centi + (centi < 0 ? -5 : 5)) / 10;
+}
 
-            if (label_max_temp_data) {
-                snprintf(text_buffer, sizeof(text_buffer), " %.1f C", max_temp);
-                lv_label_set_text(label_max_temp_data, text_buffer);
-            }
+// Only widgets on the panel follow the subjects. The others keep what
+// they showed until ui_catch_up() runs for their screen, so per-sample
+// work does not grow with the number of screens.
+static bool ui_obj_shown(const lv_obj_t *obj)
+{
+    return screen_on && lv_obj_get_screen(obj) == lv_screen_active();
+}
 
-            if (label_min_temp_data) {
-                snprintf(text_buffer, sizeof(text_buffer), " %.1f C", min_temp);
-                lv_label_set_text(label_min_temp_data, text_buffer);
-            }
+// A label shows its value's buffer in place, so an update allocates
+// nothing from the LVGL heap; a digit label redraws the cells that
+// changed. Each value has one label.
+static void label_value_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+    const ui_format_t *fmt = lv_observer_get_user_data(observer);
+    lv_obj_t *label = lv_observer_get_target_obj(observer);
+    int32_t value = lv_subject_get_int(subject);
+    char *text = ui_texts[fmt - ui_formats];
 
-            if (label_max_hum_data) {
-                snprintf(text_buffer, sizeof(text_buffer), " %.1f %%", max_hum);
-                lv_label_set_text(label_max_hum_data, text_buffer);
-            }
+    if (value == UI_VALUE_NONE || !ui_obj_shown(label)) {
+        return;
+    }
+    value_format(text, VALUE_FORMAT_MAX, fmt->prefix, value, fmt->tenths, fmt->unit);
+    if (lv_obj_check_type(label, &lv_label_class)) {
+        lv_label_set_text_static(label, text);
+    } else {
+        digit_label_set_text(label, text);
+    }
+}
 
-            if (label_min_hum_data) {
-                snprintf(text_buffer, sizeof(text_buffer), " %.1f %%", min_hum);
-                lv_label_set_text(label_min_hum_data, text_buffer);
-            }
+static void chart_sync(const graph_screen_t *graph);
+
+// The sample is already in the history the chart reads
+static void chart_sample_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+    if (lv_subject_get_pointer(subject) != NULL && ui_obj_shown(lv_observer_get_target_obj(observer))) {
+        chart_sync(lv_observer_get_user_data(observer));
+    }
+}
+
+static void ui_subjects_init(void)
+{
+    for (int i = 0; i < UI_VALUE_COUNT; i++) {
+        lv_subject_init_int(&ui_values[i], UI_VALUE_NONE);
+    }
+    lv_subject_init_pointer(&ui_sample_subject, NULL);
+    ui_sample_hist = perf_hist_register("ui_sample");
+}
+
+static void ui_bind_label(lv_obj_t *label, ui_value_t value)
+{
+    lv_subject_add_observer_obj(&ui_values[value], label_value_observer_cb, label, (void *)&ui_formats[value]);
+}
+
+static void ui_bind_chart(graph_screen_t *graph)
+{
+    lv_subject_add_observer_obj(&ui_sample_subject, chart_sample_observer_cb, graph->chart, graph);
+}
+
+// Observers run, and widgets redraw, only when the displayed value changes
+static void ui_set_value(ui_value_t value, int32_t v)
+{
+    if (lv_subject_get_int(&ui_values[value]) != v) {
+        lv_subject_set_int(&ui_values[value], v);
+    }
+}
+
+// Call with the LVGL lock held
+static void ui_publish_extrema(const ts_point_t *lo, const ts_point_t *hi)
+{
+    ui_set_value(UI_TEMP_MIN, centi_to_tenths(lo->temp_cdeg));
+    ui_set_value(UI_TEMP_MAX, centi_to_tenths(hi->temp_cdeg));
+    ui_set_value(UI_HUM_MIN, centi_to_tenths(lo->hum_cpct));
+    ui_set_value(UI_HUM_MAX, centi_to_tenths(hi->hum_cpct));
+    ui_set_value(UI_CO2_MIN, lo->co2_ppm);
+    ui_set_value(UI_CO2_MAX, hi->co2_ppm);
+}
+
+// Call with the LVGL lock held. The shown charts catch up with however
+// many samples went into the history since the last call. The time it
+// takes goes into the "ui_sample" perf histogram.
+static void ui_publish_sample(const sensor_snapshot_t *snap)
+{
+    const uint32_t start = perf_cycles();
+
+    ui_set_value(UI_TEMP, centi_to_tenths(snap->latest.temp_cdeg));
+    ui_set_value(UI_HUM, centi_to_tenths(snap->latest.hum_cpct));
+    ui_set_value(UI_CO2, snap->latest.co2_ppm);
+    ui_publish_extrema(&snap->min, &snap->max);
+
+    // Every sample moves the charts, even if the value repeats
+    ui_sample = snap->latest;
+    lv_subject_set_pointer(&ui_sample_subject, &ui_sample);
+
+    perf_hist_add(ui_sample_hist, perf_cycles_to_us(perf_cycles() - start));
+}
 
-            if (label_max_co2_data) {
-                snprintf(text_buffer, sizeof(text_buffer), " %d ppm", max_co2);
-                lv_label_set_text(label_max_co2_data, text_buffer);
+static void ui_take_sample(void);
+
+static void ui_sample_retry_cb(lv_timer_t *timer)
+{
+    ui_sample_retry = NULL;
+    ui_take_sample();
+}
+
+// Publish the newest snapshot if it has not been shown yet. The read gives
+// up if scd_task is mid-update on the other core; it is then retried from
+// a one-shot timer shortly after, instead of waiting for the next sample.
+static void ui_take_sample(void)
+{
+    sensor_snapshot_t snap;
+
+    if (!sensor_snapshot_read(&sensor_cell, &snap)) {
+        if (ui_sample_retry == NULL) {
+            ui_sample_retry = lv_timer_create(ui_sample_retry_cb, UI_SAMPLE_RETRY_MS, NULL);
+            if (ui_sample_retry != NULL) {
+                lv_timer_set_repeat_count(ui_sample_retry, 1);
             }
+        }
+        return;
+    }
+    if (snap.count != ui_seen_count) {
+        ui_publish_sample(&snap);
+        ui_seen_count = snap.count;
+    }
+}
+
+// Bring the widgets of the active screen up to date in one pass, after a
+// load or when the panel comes back on. Observers on other screens return
+// straight away.
+static void ui_catch_up(void)
+{
+    for (int i = 0; i < UI_VALUE_COUNT; i++) {
+        lv_subject_notify(&ui_values[i]);
+    }
+    lv_subject_notify(&ui_sample_subject);
+}
+
+static bool load_current_screen(void)
+{
+    // The next screen is drawn unscrolled
+    st7789_strip_stop();
+
+    if (screen_registry_load(current_screen) == NULL) {
+        return false;
+    }
+    ui_catch_up();
+    ESP_LOGI(TAG, "Switched to %s screen", screen_descs[current_screen].name);
+    return true;
+}
+
+// Runs in the LVGL task before each handler pass: apply everything other
+// tasks have queued since the last one
+static void ui_apply_queue(void)
+{
+    ui_batch_t batch;
+
+    if (!ui_queue_drain(&batch)) {
+        return;
+    }
+
+    if (batch.samples > 0) {
+        ui_take_sample();
+    }
+
+    if (batch.screen_steps != 0) {
+        const int previous = current_screen;
+        current_screen = ((current_screen + batch.screen_steps) % SCREEN_COUNT + SCREEN_COUNT) % SCREEN_COUNT;
+        if (!load_current_screen()) {
+            current_screen = previous;
+        }
+        switch_edge_us = atomic_exchange(&input_edge_us, 0);
+    }
+
+    if (batch.rotations % 2) {
+        screen_rotation = screen_rotation == LV_DISP_ROT_270 ? LV_DISP_ROT_90 : LV_DISP_ROT_270;
+        st7789_set_rotation(screen_rotation);
+    }
+
+    if (batch.power_toggles % 2) {
+        // Backlight and panel sleep together; nothing is rendered while
+        // the screen is off. Widgets catch up first, so the redraw the
+        // panel does once it is awake shows current values.
+        screen_on = !screen_on;
+        if (screen_on) {
+            ui_catch_up();
+        } else {
+            // Turning the screen off often comes before unplugging;
+            // program the partial page now
+            sample_log_flush();
+        }
+        st7789_set_power(screen_on);
+        power_set_backlight(screen_on);
+        scd41_async_set_low_power(LOW_POWER_MODE || !screen_on);
+        ESP_LOGI(TAG, "Screen %s", screen_on ? "ON" : "OFF");
+    }
 
-            if (label_min_co2_data) {
-                snprintf(text_buffer, sizeof(text_buffer), " %d ppm", min_co2);
-                lv_label_set_text(label_min_co2_data, text_buffer);
+    if (batch.screen_steps != 0 || batch.power_toggles % 2) {
+        diag_screen_set_visible(screen_on && current_screen == SCREEN_DIAG);
+    }
+}
+
+// The render pass after a screen switch is where the user sees it
+static void ui_refr_ready_cb(lv_event_t *e)
+{
+    if (switch_edge_us != 0) {
+        input_note_handled(switch_edge_us);
+        switch_edge_us = 0;
+    }
+}
+
+// esp_timer task: turn gestures into UI commands
+static void input_event_cb(const input_event_t *event, void *ctx)
+{
+    switch (event->button) {
+        case BUTTON_ON_OFF:
+            if (event->gesture == INPUT_SHORT_PRESS) {
+                ui_queue_post(UI_CMD_SCREEN_POWER, 0);
+            } else if (event->gesture == INPUT_DOUBLE_PRESS) {
+                ui_queue_post(UI_CMD_ROTATE, 0);
             }
+            break;
+        case BUTTON_NEXT:
+            atomic_store(&input_edge_us, event->edge_us);
+            ui_queue_post(UI_CMD_NEXT_SCREEN, event->gesture == INPUT_LONG_PRESS ? -1 : 1);
+            break;
+        default:
+            break;
+    }
+}
+
+#if SENSOR_DIGIT_ATLAS
+LV_FONT_DECLARE(jet_mono_light_32)
+
+// Rendered when the sensor screen is first built, at boot, and kept for
+// its rebuilds. NULL if there was no memory; the readings are labels then.
+static const digit_atlas_t *value_atlas(void)
+{
+    static const digit_atlas_t *atlas = NULL;
+    static bool tried = false;
+
+    if (!tried) {
+        tried = true;
+        atlas = digit_atlas_create(&jet_mono_light_32, VALUE_ATLAS_CHARSET, UI_COLOR_TEXT, UI_COLOR_BG);
+        if (atlas == NULL) {
+            ESP_LOGW(TAG, "No memory for the reading glyph atlas, drawing labels");
+        } else {
+            ESP_LOGI(TAG, "Reading glyph atlas: %u bytes", (unsigned)digit_atlas_get_size(atlas));
         }
-        xSemaphoreGive(data_mutex);
     }
+    return atlas;
 }
-// in lv_color_make order is BRG with RGB565 notation
-// max values are: 31, 31, 63
-void create_sensor_co2(const lv_font_t *font_label, const lv_font_t *font_value)
+#endif
+
+// Caption and value of one reading on the sensor screen
+static lv_obj_t *create_sensor_reading(const char *caption, const lv_style_t *caption_style,
+                                       const char *placeholder, int32_t y)
 {
-    // CO2 Label and Value
-    lv_obj_t *label_co2_text = lv_label_create(screen_sensor);  // Changed from lv_screen_active()
-    lv_label_set_text(label_co2_text, "CO2");
-    lv_obj_set_style_text_font(label_co2_text, font_label, 0);
-    lv_obj_set_style_text_color(label_co2_text, lv_color_make(31, 31, 63), 0);
-    lv_obj_set_pos(label_co2_text, 10, 60);
-    
-    label_co2 = lv_label_create(screen_sensor);  // Changed from lv_screen_active()
-    lv_label_set_text(label_co2, ": -- ppm");
-    lv_obj_set_style_text_font(label_co2, font_value, 0);
-    lv_obj_set_style_text_color(label_co2, lv_color_make(31, 31, 63), 0);
-    lv_obj_set_pos(label_co2, 80, 60);
+    const ui_theme_t *th = ui_theme_get();
+    lv_obj_t *label_value = NULL;
+
+    lv_obj_t *label_caption = lv_label_create(screen_sensor);
+    lv_label_set_text(label_caption, caption);
+    ui_theme_apply(label_caption, caption_style, 0);
+    lv_obj_set_pos(label_caption, 10, y);
+
+#if SENSOR_DIGIT_ATLAS
+    const digit_atlas_t *atlas = value_atlas();
+    if (atlas != NULL) {
+        label_value = digit_label_create(screen_sensor, atlas, VALUE_ATLAS_CELLS);
+        if (label_value != NULL) {
+            digit_label_set_text(label_value, placeholder);
+        }
+    }
+#endif
+    if (label_value == NULL) {
+        label_value = lv_label_create(screen_sensor);
+        lv_label_set_text_static(label_value, placeholder);
+        ui_theme_apply(label_value, th->value, 0);
+    }
+    lv_obj_set_pos(label_value, 80, y);
+    return label_value;
 }
 
-void create_sensor_temp(const lv_font_t *font_label, const lv_font_t *font_value)
+void create_sensor_co2(const lv_style_t *caption_style)
 {
-    // Temperature Label and Value
-    lv_obj_t *label_temp_text = lv_label_create(screen_sensor);  // Changed
-    lv_label_set_text(label_temp_text, "湿度");
-    lv_obj_set_style_text_font(label_temp_text, font_label, 0);
-    lv_obj_set_style_text_color(label_temp_text, lv_color_make(31, 31, 63), 0);
-    lv_obj_set_pos(label_temp_text, 10, 110);
-    
-    label_temp = lv_label_create(screen_sensor);  // Changed
-    lv_label_set_text(label_temp, ": -- C");
-    lv_obj_set_style_text_font(label_temp, font_value, 0);
-    lv_obj_set_style_text_color(label_temp, lv_color_make(31, 31, 63), 0);
-    lv_obj_set_pos(label_temp, 80, 110);
+    label_co2 = create_sensor_reading("CO2", caption_style, ": -- ppm", 60);
 }
 
-void create_sensor_hum(const lv_font_t *font_label, const lv_font_t *font_value)
+void create_sensor_temp(const lv_style_t *caption_style)
 {
-    // Humidity Label and Value
-    lv_obj_t *label_humid_text = lv_label_create(screen_sensor);  // Changed
-    lv_label_set_text(label_humid_text, "温度");
-    lv_obj_set_style_text_font(label_humid_text, font_label, 0);
-    lv_obj_set_style_text_color(label_humid_text, lv_color_make(31, 31, 63), 0);
-    lv_obj_set_pos(label_humid_text, 10, 160);
-    
-    label_humid = lv_label_create(screen_sensor);  // Changed
-    lv_label_set_text(label_humid, ": -- %");
-    lv_obj_set_style_text_font(label_humid, font_value, 0);
-    lv_obj_set_style_text_color(label_humid, lv_color_make(31, 31, 63), 0);
-    lv_obj_set_pos(label_humid, 80, 160);
+    label_temp = create_sensor_reading("湿度", caption_style, ": -- C", 110);
 }
+
+void create_sensor_hum(const lv_style_t *caption_style)
+{
+    label_humid = create_sensor_reading("温度", caption_style, ": -- %", 160);
+}
+
 // Create the sensor screen
 void create_sensor_screen()
 {
-    extern lv_font_t jet_mono_light_32;
-    extern lv_font_t noto_sans_jap;
-    
-    // Create sensor screen
+    const ui_theme_t *th = ui_theme_get();
+
     screen_sensor = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(screen_sensor, lv_color_make(0, 0, 0), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(screen_sensor, LV_OPA_COVER, LV_PART_MAIN);
-    
-    // Add title
+    ui_theme_apply(screen_sensor, th->screen, 0);
+
     lv_obj_t *label_title = lv_label_create(screen_sensor);
     lv_label_set_text(label_title, "Sensor Monitor");
-    lv_obj_set_style_text_font(label_title, &jet_mono_light_32, 0);
-    lv_obj_set_style_text_color(label_title, lv_color_make(31, 31, 63), 0);
+    ui_theme_apply(label_title, th->value, 0);
     lv_obj_set_pos(label_title, 10, 10);
-    
-    // Create sensor labels
-    create_sensor_co2(&jet_mono_light_32, &jet_mono_light_32);
-    create_sensor_temp(&noto_sans_jap, &jet_mono_light_32);
-    create_sensor_hum(&noto_sans_jap, &jet_mono_light_32);
+
+    create_sensor_co2(th->value);
+    create_sensor_temp(th->caption_jp);
+    create_sensor_hum(th->caption_jp);
 }
 
+// Charts plot the stored fixed-point values directly; only their y range
+// is scaled from display units
+static int32_t chart_scale(ts_channel_t channel)
+{
+    return channel == TS_CH_CO2 ? 1 : 100;
+}
+
+// Make a chart draw one channel of the raw history in place. Slots not
+// written yet are SAMPLE_STORE_RAW_EMPTY, which the chart skips.
+#if !GRAPH_STRIP_CHART
+_Static_assert(SAMPLE_STORE_RAW_EMPTY == LV_CHART_POINT_NONE, "empty history slots are not drawn");
+#endif
+static void chart_bind_history(const graph_screen_t *graph)
+{
+    int32_t *values = sample_store_raw_channel(&history, graph->channel);
+
+#if GRAPH_STRIP_CHART
+    strip_chart_set_ext_values(graph->chart, values, SAMPLE_STORE_RAW_SLOTS);
+#else
+    // LVGL only reads the array; the series' own one is freed, and the
+    // point count does not allocate for an external array
+    lv_chart_set_ext_y_array(graph->chart, graph->series, values);
+    lv_chart_set_point_count(graph->chart, SAMPLE_STORE_RAW_SLOTS);
+#endif
+    chart_sync(graph);
+}
+
+// Start the chart at the oldest slot of the history ring. Only the ring
+// position needs the mutex; a sample written while the chart is drawn is
+// at worst shown one update early in the oldest slot.
+static void chart_sync(const graph_screen_t *graph)
+{
+    uint32_t head, count;
+
+    if (xSemaphoreTake(history_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    head = sample_store_head(&history, TS_TIER_RAW);
+    count = sample_store_count(&history, TS_TIER_RAW);
+    xSemaphoreGive(history_mutex);
+
+#if GRAPH_STRIP_CHART
+    strip_chart_ext_sync(graph->chart, head, count);
+#else
+    (void)count;
+    lv_chart_set_x_start_point(graph->chart, graph->series, head);
+    lv_chart_refresh(graph->chart);
+#endif
+}
+
+#if GRAPH_STRIP_CHART
+static bool graph_hw_scroll(const lv_area_t *band, int32_t columns)
+{
+    return st7789_strip_scroll(band->x1, lv_area_get_width(band), columns) == ESP_OK;
+}
+
+// Strip layout: y axis on the left, the chart over the full height, and
+// min/max stacked on the right, outside the scrolled columns
+void create_graph_screen(lv_obj_t **graph, lv_obj_t **lv_max_data, lv_obj_t **lv_min_data,
+                         lv_obj_t **chart, lv_chart_series_t **series, int y_high_lim,
+                         ts_channel_t channel)
+{
+    const ui_theme_t *th = ui_theme_get();
+
+    *graph = lv_obj_create(NULL);
+    ui_theme_apply(*graph, th->screen, 0);
+
+    const strip_chart_cfg_t cfg = {
+        .points = GRAPH_STRIP_POINTS,
+        .step = GRAPH_STRIP_STEP,
+        .min = 0,
+        .max = y_high_lim * chart_scale(channel),
+        .h_div = 5,
+        .v_div_every = GRAPH_STRIP_GRID_EVERY,
+        .line_width = 3,
+        .line_color = UI_COLOR_SERIES,
+        .grid_color = UI_COLOR_GRID,
+        .fill_opa = LV_OPA_50,
+    };
+    *chart = strip_chart_create(*graph, &cfg);
+    *series = NULL;
+    if (*chart == NULL) {
+        ESP_LOGE(TAG, "No memory for strip chart");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+    lv_obj_set_height(*chart, lv_pct(100));
+    lv_obj_set_pos(*chart, 32, 0);
+    lv_obj_set_style_pad_ver(*chart, 10, LV_PART_MAIN);
+
+    // Y axis spans the chart's plot rows
+    lv_obj_t *scale_y = lv_scale_create(*graph);
+    lv_obj_set_size(scale_y, 25, 220);
+    lv_obj_set_pos(scale_y, 5, 10);
+    lv_scale_set_mode(scale_y, LV_SCALE_MODE_VERTICAL_LEFT);
+    lv_scale_set_range(scale_y, 0, y_high_lim);
+    lv_scale_set_total_tick_count(scale_y, 9);
+    lv_scale_set_major_tick_every(scale_y, 2);
+    ui_theme_apply(scale_y, th->text_dim, 0);
+    ui_theme_apply(scale_y, th->axis_ticks, LV_PART_INDICATOR);
+
+    const int32_t col_x = 32 + GRAPH_STRIP_POINTS * GRAPH_STRIP_STEP + 4;
+
+    lv_obj_t *label_max = lv_label_create(*graph);
+    lv_label_set_text(label_max, "Max:");
+    ui_theme_apply(label_max, th->label_max, 0);
+    lv_obj_set_pos(label_max, col_x, 60);
+
+    *lv_max_data = lv_label_create(*graph);
+    lv_label_set_text_static(*lv_max_data, " --");
+    ui_theme_apply(*lv_max_data, th->text, 0);
+    lv_obj_set_pos(*lv_max_data, col_x, 80);
+
+    lv_obj_t *label_min = lv_label_create(*graph);
+    lv_label_set_text(label_min, "Min:");
+    ui_theme_apply(label_min, th->label_min, 0);
+    lv_obj_set_pos(label_min, col_x, 140);
+
+    *lv_min_data = lv_label_create(*graph);
+    lv_label_set_text_static(*lv_min_data, " --");
+    ui_theme_apply(*lv_min_data, th->text, 0);
+    lv_obj_set_pos(*lv_min_data, col_x, 160);
+}
+#else
 void create_graph_screen(lv_obj_t **graph, lv_obj_t **lv_max_data, lv_obj_t **lv_min_data,
-                         lv_obj_t **chart, lv_chart_series_t **series, int y_high_lim)
+                         lv_obj_t **chart, lv_chart_series_t **series, int y_high_lim,
+                         ts_channel_t channel)
 {
+    const ui_theme_t *th = ui_theme_get();
+
     *graph = lv_obj_create(NULL);
-    lv_obj_set_style_bg_color(*graph, lv_color_make(0, 0, 0), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(*graph, LV_OPA_COVER, LV_PART_MAIN);
+    ui_theme_apply(*graph, th->screen, 0);
     
     // Max label
     lv_obj_t *label_max = lv_label_create(*graph);
     lv_label_set_text(label_max, "Max:");
-    lv_obj_set_style_text_font(label_max, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(label_max, lv_color_make(0, 31, 0), 0);
+    ui_theme_apply(label_max, th->label_max, 0);
     lv_obj_set_pos(label_max, 70, 220);
 
     // Max data
     *lv_max_data = lv_label_create(*graph);
-    lv_label_set_text(*lv_max_data, " --");
-    lv_obj_set_style_text_font(*lv_max_data, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(*lv_max_data, lv_color_make(31, 31, 63), 0);
+    lv_label_set_text_static(*lv_max_data, " --");
+    ui_theme_apply(*lv_max_data, th->text, 0);
     lv_obj_set_pos(*lv_max_data, 100, 220);
 
     // Min label
     lv_obj_t *label_min = lv_label_create(*graph);
     lv_label_set_text(label_min, "Min:");
-    lv_obj_set_style_text_font(label_min, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(label_min, lv_color_make(31, 0, 0), 0);
+    ui_theme_apply(label_min, th->label_min, 0);
     lv_obj_set_pos(label_min, 170, 220);
 
     // Min data
     *lv_min_data = lv_label_create(*graph);
-    lv_label_set_text(*lv_min_data, " --");
-    lv_obj_set_style_text_font(*lv_min_data, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(*lv_min_data, lv_color_make(31, 31, 63), 0);
+    lv_label_set_text_static(*lv_min_data, " --");
+    ui_theme_apply(*lv_min_data, th->text, 0);
     lv_obj_set_pos(*lv_min_data, 200, 220);
 
     // Create scale for Y-axis
@@ -242,23 +731,19 @@ void create_graph_screen(lv_obj_t **graph, lv_obj_t **lv_max_data, lv_obj_t **lv
     lv_scale_set_range(scale_y, 0, y_high_lim);
     lv_scale_set_total_tick_count(scale_y, 9);
     lv_scale_set_major_tick_every(scale_y, 2);
-    lv_obj_set_style_text_font(scale_y, &lv_font_montserrat_10, 0);
-    lv_obj_set_style_text_color(scale_y, lv_color_make(20, 20, 40), 0);
-    lv_obj_set_style_line_color(scale_y, lv_color_make(15, 15, 30), LV_PART_INDICATOR);
-    lv_obj_set_style_length(scale_y, 5, LV_PART_INDICATOR);
+    ui_theme_apply(scale_y, th->text_dim, 0);
+    ui_theme_apply(scale_y, th->axis_ticks, LV_PART_INDICATOR);
     
     // Create scale for X-axis (time)
     lv_obj_t *scale_x = lv_scale_create(*graph);
     lv_obj_set_size(scale_x, 250, 25);
     lv_obj_set_pos(scale_x, 35, 190);
     lv_scale_set_mode(scale_x, LV_SCALE_MODE_HORIZONTAL_BOTTOM);
-    lv_scale_set_range(scale_x, -55, 0);
-    lv_scale_set_total_tick_count(scale_x, 12);
-    lv_scale_set_major_tick_every(scale_x, 2);
-    lv_obj_set_style_text_font(scale_x, &lv_font_montserrat_10, 0);
-    lv_obj_set_style_text_color(scale_x, lv_color_make(20, 20, 40), 0);
-    lv_obj_set_style_line_color(scale_x, lv_color_make(15, 15, 30), LV_PART_INDICATOR);
-    lv_obj_set_style_length(scale_x, 5, LV_PART_INDICATOR);
+    lv_scale_set_range(scale_x, -GRAPH_WINDOW_MIN, 0);
+    lv_scale_set_total_tick_count(scale_x, 13);
+    lv_scale_set_major_tick_every(scale_x, 3);
+    ui_theme_apply(scale_x, th->text_dim, 0);
+    ui_theme_apply(scale_x, th->axis_ticks, LV_PART_INDICATOR);
  
     // Create line
     static lv_point_precise_t line_points[] = {
@@ -269,314 +754,395 @@ void create_graph_screen(lv_obj_t **graph, lv_obj_t **lv_max_data, lv_obj_t **lv
     // Create line object
     lv_obj_t *line = lv_line_create(*graph);
     lv_line_set_points(line, line_points, 2);
+    ui_theme_apply(line, th->rule, 0);
 
     // Position the line
     lv_obj_set_pos(line, 0, 212);
-
-    // Style the line
-    lv_obj_set_style_line_width(line, 2, 0);
-    lv_obj_set_style_line_color(line, lv_color_make(31, 31, 63), 0);
     
     // Create chart
     *chart = lv_chart_create(*graph);
     lv_obj_set_size(*chart, 260, 180);
     lv_obj_set_pos(*chart, 30, 10);
-    
-    // Chart styling
-    lv_obj_set_style_bg_color(*chart, lv_color_make(0, 0, 0), LV_PART_MAIN);
-    lv_obj_set_style_border_width(*chart, 1, LV_PART_MAIN);
-    lv_obj_set_style_border_color(*chart, lv_color_make(15, 15, 31), LV_PART_MAIN);
-    lv_obj_set_style_pad_all(*chart, 5, LV_PART_MAIN);
+    ui_theme_apply(*chart, th->chart, LV_PART_MAIN);
     
     // Configure chart
     lv_chart_set_type(*chart, LV_CHART_TYPE_LINE);
-    lv_chart_set_point_count(*chart, 12);
-    lv_chart_set_range(*chart, LV_CHART_AXIS_PRIMARY_Y, 0, y_high_lim);
+    lv_chart_set_range(*chart, LV_CHART_AXIS_PRIMARY_Y, 0, y_high_lim * chart_scale(channel));
     lv_chart_set_update_mode(*chart, LV_CHART_UPDATE_MODE_SHIFT);
     lv_chart_set_div_line_count(*chart, 5, 0);
     
-    // Grid styling
-    lv_obj_set_style_line_color(*chart, lv_color_make(10, 10, 20), LV_PART_MAIN);
-    lv_obj_set_style_line_width(*chart, 1, LV_PART_MAIN);
-    
     // Add series
-    *series = lv_chart_add_series(*chart, lv_color_make(31, 20, 50), LV_CHART_AXIS_PRIMARY_Y);
-    
-    // Style the line
-    lv_obj_set_style_line_width(*chart, 3, LV_PART_ITEMS);
-    lv_obj_set_style_bg_opa(*chart, LV_OPA_50, LV_PART_ITEMS);
-    lv_obj_set_style_bg_color(*chart, lv_color_make(31, 20, 50), LV_PART_ITEMS);
-    
-    // Initialize
-    for (int i = 0; i < 12; i++) {
-        lv_chart_set_next_value(*chart, *series, 0);
-    }
-    
-    lv_chart_refresh(*chart);
+    *series = lv_chart_add_series(*chart, UI_COLOR_SERIES, LV_CHART_AXIS_PRIMARY_Y);
+    ui_theme_apply(*chart, th->series, LV_PART_ITEMS);
 }
+#endif
 
-void update_chart(uint16_t temp_value, uint16_t hum_value, uint16_t co2_value)
+static void sensor_screen_delete_cb(lv_event_t *e)
 {
+    screen_sensor = NULL;
+    label_co2 = NULL;
+    label_temp = NULL;
+    label_humid = NULL;
+}
 
-    if (temp_chart && temp_series) {
-        lvgl_port_lock(0);
-        lv_chart_set_next_value(temp_chart, temp_series, temp_value);
-        lv_chart_refresh(temp_chart);
-        lvgl_port_unlock();
-    }
+// Bound labels show the current values right away
+static lv_obj_t *sensor_screen_build(void *ctx)
+{
+    create_sensor_screen();
+    ui_bind_label(label_temp, UI_TEMP);
+    ui_bind_label(label_humid, UI_HUM);
+    ui_bind_label(label_co2, UI_CO2);
+    lv_obj_add_event_cb(screen_sensor, sensor_screen_delete_cb, LV_EVENT_DELETE, NULL);
+    return screen_sensor;
+}
 
-    if (hum_chart && hum_series) {
-        lvgl_port_lock(0);
-        lv_chart_set_next_value(hum_chart, hum_series, hum_value);
-        lv_chart_refresh(hum_chart);
-        lvgl_port_unlock();
-    }
+static void graph_screen_delete_cb(lv_event_t *e)
+{
+    graph_screen_t *graph = lv_event_get_user_data(e);
 
-    if (co2_chart && co2_series) {
-        lvgl_port_lock(0);
-        lv_chart_set_next_value(co2_chart, co2_series, co2_value);
-        lv_chart_refresh(co2_chart);
-        lvgl_port_unlock();
-    }
+    graph->screen = NULL;
+    graph->chart = NULL;
+    graph->series = NULL;
+    graph->label_max = NULL;
+    graph->label_min = NULL;
 }
 
-void create_sensor_labels()
+// The chart reads the history, which has every sample so far
+static lv_obj_t *graph_screen_build(void *ctx)
 {
-    // Create LVGL timer to update UI every 500ms
-    lv_timer_create(lvgl_update_timer_cb, 500, NULL);
+    graph_screen_t *graph = ctx;
+
+    create_graph_screen(&graph->screen, &graph->label_max, &graph->label_min, &graph->chart, &graph->series,
+                        graph->y_high_lim, graph->channel);
+    ui_bind_label(graph->label_min, graph->value_min);
+    ui_bind_label(graph->label_max, graph->value_max);
+    chart_bind_history(graph);
+    ui_bind_chart(graph);
+    lv_obj_add_event_cb(graph->screen, graph_screen_delete_cb, LV_EVENT_DELETE, graph);
+    return graph->screen;
 }
 
-void on_off_button_task(void *arg)
+static lv_obj_t *diag_screen_build(void *ctx)
 {
-   // Configure GPIO as input
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << ON_OFF_BUTTON),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,  // Enable internal pull-up
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
-    };
-    gpio_config(&io_conf);
+    return diag_screen_create();
+}
 
-    bool last_state = true;
-    bool current_state;
-    bool screen_state = true;
-    
-    ESP_LOGI(TAG, "Button monitoring started on GPIO %d", ON_OFF_BUTTON);
+// Firmware order of the next button
+static const screen_desc_t screen_descs[SCREEN_COUNT] = {
+    [SCREEN_SENSOR] = {"Sensor", sensor_screen_build, NULL},
+    [SCREEN_TEMP] = {"Temperature graph", graph_screen_build, &graphs[0]},    // 0-40 C
+    [SCREEN_HUM] = {"Humidity graph", graph_screen_build, &graphs[1]},       // 0-100 %
+    [SCREEN_CO2] = {"CO2 graph", graph_screen_build, &graphs[2]},            // 0-2000 ppm
+    [SCREEN_DIAG] = {"Diagnostics", diag_screen_build, NULL},
+};
 
-    while (1) {
-        current_state = gpio_get_level(ON_OFF_BUTTON);
-        
-        if (last_state && !current_state) {
-            vTaskDelay(pdMS_TO_TICKS(DEBOUNCE_TIME_MS));
-            current_state = gpio_get_level(ON_OFF_BUTTON);
-            
-            if (!current_state) {
-                ESP_LOGI(TAG, "Power button PRESSED");
-                
-                screen_state = !screen_state;
-                
-                // Just toggle the backlight GPIO
-                gpio_set_level(PIN_NUM_BK_LIGHT, screen_state ? 1 : 0);
-                ESP_LOGI(TAG, "Backlight %s", screen_state ? "ON" : "OFF");
-            }
+// The window is owned by scd_task once it runs
+static void window_minmax(ts_point_t *min, ts_point_t *max)
+{
+    int32_t lo, hi;
+
+    if (window_extrema_get(&minmax_window, WEXT_CH_TEMP, &lo, &hi)) {
+        min->temp_cdeg = lo;
+        max->temp_cdeg = hi;
+    }
+    if (window_extrema_get(&minmax_window, WEXT_CH_HUM, &lo, &hi)) {
+        min->hum_cpct = lo;
+        max->hum_cpct = hi;
+    }
+    if (window_extrema_get(&minmax_window, WEXT_CH_CO2, &lo, &hi)) {
+        min->co2_ppm = lo;
+        max->co2_ppm = hi;
+    }
+}
+
+// Buckets the span's tier closed since the last call go into its window.
+// Empty buckets, gaps in the history, are skipped, so across a gap the
+// window reaches further back than its span. Call with the history held.
+static void span_feed(span_extrema_t *span)
+{
+    const uint32_t head = sample_store_head(&history, span->tier);
+    const uint32_t slots = sample_store_capacity(span->tier);
+    uint32_t age = (head + slots - span->seen_head) % slots;
+
+    span->seen_head = head;
+    while (age-- > 0) {
+        ts_bucket_t b;
+        if (!sample_store_get(&history, span->tier, age, &b) || b.count == 0) {
+            continue;
         }
-        
-        last_state = current_state;
-        vTaskDelay(pdMS_TO_TICKS(10));
+        const int32_t lo[WEXT_CHANNELS] = {
+            [WEXT_CH_TEMP] = b.min.temp_cdeg,
+            [WEXT_CH_HUM] = b.min.hum_cpct,
+            [WEXT_CH_CO2] = b.min.co2_ppm,
+        };
+        const int32_t hi[WEXT_CHANNELS] = {
+            [WEXT_CH_TEMP] = b.max.temp_cdeg,
+            [WEXT_CH_HUM] = b.max.hum_cpct,
+            [WEXT_CH_CO2] = b.max.co2_ppm,
+        };
+        window_extrema_push_range(&span->window, lo, hi);
     }
 }
 
-void next_screen_button_task(void *arg)
+// Min/max over the span's closed buckets and the one still open; false
+// before the first sample. Call with the history held.
+static bool span_minmax(const span_extrema_t *span, ts_point_t *min, ts_point_t *max)
 {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << NEXT_SCREEN_BUTTON),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
+    ts_bucket_t open;
+    const bool have_open = sample_store_partial(&history, span->tier, &open);
+    const bool have_closed = window_extrema_count(&span->window) > 0;
+    int32_t lo[WEXT_CHANNELS], hi[WEXT_CHANNELS];
+
+    if (!have_open && !have_closed) {
+        return false;
+    }
+    for (int ch = 0; ch < WEXT_CHANNELS; ch++) {
+        lo[ch] = INT32_MAX;
+        hi[ch] = INT32_MIN;
+        if (have_closed) {
+            window_extrema_get(&span->window, ch, &lo[ch], &hi[ch]);
+        }
+        if (have_open) {
+            const int32_t open_lo = ts_point_get(&open.min, (ts_channel_t)ch);
+            const int32_t open_hi = ts_point_get(&open.max, (ts_channel_t)ch);
+            lo[ch] = open_lo < lo[ch] ? open_lo : lo[ch];
+            hi[ch] = open_hi > hi[ch] ? open_hi : hi[ch];
+        }
+    }
+    *min = (ts_point_t) {
+        .temp_cdeg = (int16_t)lo[WEXT_CH_TEMP],
+        .hum_cpct = (uint16_t)lo[WEXT_CH_HUM],
+        .co2_ppm = (uint16_t)lo[WEXT_CH_CO2],
+    };
+    *max = (ts_point_t) {
+        .temp_cdeg = (int16_t)hi[WEXT_CH_TEMP],
+        .hum_cpct = (uint16_t)hi[WEXT_CH_HUM],
+        .co2_ppm = (uint16_t)hi[WEXT_CH_CO2],
     };
-    gpio_config(&io_conf);
+    return true;
+}
 
-    bool last_state = true;
-    bool current_state;
-    
-    ESP_LOGI(TAG, "Button monitoring started on GPIO %d", NEXT_SCREEN_BUTTON);
+// Replays logged samples into the in-RAM history before any task runs
+static void restore_sample_cb(uint32_t time_s, const ts_point_t *point, void *ctx)
+{
+    const int32_t values[WEXT_CHANNELS] = {
+        [WEXT_CH_TEMP] = point->temp_cdeg,
+        [WEXT_CH_HUM] = point->hum_cpct,
+        [WEXT_CH_CO2] = point->co2_ppm,
+    };
 
-    while (1) {
-        current_state = gpio_get_level(NEXT_SCREEN_BUTTON);
-        
-        if (last_state && !current_state) {
-            vTaskDelay(pdMS_TO_TICKS(DEBOUNCE_TIME_MS));
-            current_state = gpio_get_level(NEXT_SCREEN_BUTTON);
-            
-            if (!current_state) {
-                ESP_LOGI(TAG, "Next Button PRESSED");
-                
-                // Toggle between screens
-                current_screen = (current_screen + 1) % 4;
-                if (lvgl_port_lock(0)) {
-                    switch (current_screen) {
-                        case 0:
-                            lv_screen_load(screen_sensor);
-                            ESP_LOGI(TAG, "Switched to Sensor screen");
-                            break;
-                        case 1:
-                            lv_screen_load(screen_temp_graph);
-                            ESP_LOGI(TAG, "Switched to Temperature graph screen");
-                            break;
-                        case 2:
-                            lv_screen_load(screen_hum_graph);
-                            ESP_LOGI(TAG, "Switched to Humidity graph screen");
-                            break;
-                        case 3:
-                            lv_screen_load(screen_co2_graph);
-                            ESP_LOGI(TAG, "Switched to CO2 graph screen");
-                            break;
-                        default:
-                            lv_screen_load(screen_sensor);
-                            ESP_LOGI(TAG, "Default: Switched to Sensor screen");
-                            break;
-                    }
-                    lvgl_port_unlock();
-                }
-            }
+    sample_store_add(&history, time_s, point);
+    window_extrema_push(&minmax_window, values);
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        span_feed(&spans[i]);
+    }
+}
+
+// Bus activity since the last call goes into the energy accounts
+static void power_account_buses(void)
+{
+    static uint64_t last_spi_bytes = 0;
+    static uint64_t last_i2c_bytes = 0;
+    st7789_flush_stats_t fl;
+    scd41_async_stats_t sc;
+
+    st7789_get_flush_stats(&fl);
+    power_add_active(ENERGY_SPI, (uint32_t)((fl.bytes - last_spi_bytes) * 8 * 1000000 / LCD_PIXEL_CLK_HZ));
+    last_spi_bytes = fl.bytes;
+
+    // 9 clocks per byte including the ACK
+    scd41_async_get_stats(&sc);
+    power_add_active(ENERGY_I2C, (uint32_t)((sc.bytes - last_i2c_bytes) * 9 * 1000000 / I2C_MASTER_FREQ_HZ));
+    last_i2c_bytes = sc.bytes;
+}
+
+static void power_log_report(void)
+{
+    energy_report_t report;
+
+    power_get_report(&report);
+    ESP_LOGI(TAG, "Energy over %llu s: %llu uAh, avg %u uA",
+             (unsigned long long)(report.elapsed_us / 1000000),
+             (unsigned long long)(report.total_nah / 1000), (unsigned)report.avg_ua);
+    for (int rail = 0; rail < ENERGY_RAIL_COUNT; rail++) {
+        ESP_LOGI(TAG, "  %-9s duty %4u/1000  %llu uAh", energy_rail_name(rail),
+                 (unsigned)report.duty_permille[rail], (unsigned long long)(report.charge_nah[rail] / 1000));
+    }
+}
+
+// Hour and day min/max, formatted like the graph labels
+static void span_log_report(void)
+{
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        ts_point_t lo, hi;
+        bool ok = false;
+
+        if (xSemaphoreTake(history_mutex, portMAX_DELAY) == pdTRUE) {
+            ok = span_minmax(&spans[i], &lo, &hi);
+            xSemaphoreGive(history_mutex);
+        }
+        if (!ok) {
+            continue;
         }
 
-        last_state = current_state;
-        vTaskDelay(pdMS_TO_TICKS(20));
+        char text[6][VALUE_FORMAT_MAX];
+        value_format(text[0], sizeof(text[0]), "", centi_to_tenths(lo.temp_cdeg), true, "C");
+        value_format(text[1], sizeof(text[1]), "", centi_to_tenths(hi.temp_cdeg), true, "C");
+        value_format(text[2], sizeof(text[2]), "", centi_to_tenths(lo.hum_cpct), true, "%");
+        value_format(text[3], sizeof(text[3]), "", centi_to_tenths(hi.hum_cpct), true, "%");
+        value_format(text[4], sizeof(text[4]), "", lo.co2_ppm, false, "ppm");
+        value_format(text[5], sizeof(text[5]), "", hi.co2_ppm, false, "ppm");
+        ESP_LOGI(TAG, "Last %s: %s..%s, %s..%s, %s..%s", spans[i].name, text[0], text[1], text[2], text[3],
+                 text[4], text[5]);
     }
 }
 
 void scd_task(void *arg)
 {
-    // Configure I2C master
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
-    };
-    ESP_ERROR_CHECK(i2c_param_config(I2C_NUM_0, &conf));
-    ESP_ERROR_CHECK(i2c_driver_install(I2C_NUM_0, conf.mode, 0, 0, 0));
-    
-    // Initialize SCD41
-    scd41_config_t config = SCD41_CONFIG_DEFAULT();
-    config.i2c_port = I2C_NUM_0;
-    config.timeout_ms = 1000;
-    
-    ESP_ERROR_CHECK(scd41_init(&config));
-    ESP_ERROR_CHECK(scd41_start_measurement());
-    
-    // Wait for first measurement (5 seconds)
-    vTaskDelay(pdMS_TO_TICKS(5000));
-    
+    scd41_async_cfg_t cfg = SCD41_ASYNC_DEFAULT_CONFIG(I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO);
+    cfg.clk_hz = I2C_MASTER_FREQ_HZ;
+    cfg.low_power = LOW_POWER_MODE;
+    cfg.fixed_schedule = SCD41_FIXED_SCHEDULE;
+
+    ESP_ERROR_CHECK(scd41_async_start(&cfg));
+    power_set_sensor_low_power(LOW_POWER_MODE);
+
+    sensor_snapshot_t snap = {0};
+    uint32_t next_report_s = sample_log_time_s() + POWER_REPORT_PERIOD_S;
+    perf_hist_t *jitter_hist = perf_hist_register("scd_jitter");
+    int64_t last_read_us = 0;
+    bool low_power = LOW_POWER_MODE;
+
     while (1) {
-        scd41_data_t data;
-        esp_err_t ret = scd41_read_measurement(&data);
-        
-        if (ret == ESP_OK && data.data_ready) {
-            if (xSemaphoreTake(data_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                sensor_data = data;
-                xSemaphoreGive(data_mutex);
-            }
-            
-            update_chart(data.temperature, data.humidity, data.co2_ppm);
-            
-            data_buffer[data_buffer_index] = data;
-
-            min_temp = data_buffer[0].temperature;
-            max_temp = data_buffer[0].temperature;
-            min_co2 = data_buffer[0].co2_ppm;
-            max_co2 = data_buffer[0].co2_ppm;
-            min_hum = data_buffer[0].humidity;
-            max_hum = data_buffer[0].humidity;
-            
-            data_buffer_index++;
-            if (data_buffer_index >= 12) {
-                data_buffer_index = 0;
-            }
+        // The driver paces itself on the sensor's data-ready flag; this
+        // task only waits for what it delivers
+        scd41_sample_t sample;
 
-            for (int i = 1; i < 12; i++) {
-                if (data_buffer[i].temperature < min_temp) {
-                    min_temp = data_buffer[i].temperature;
-                }
-                if (data_buffer[i].temperature > max_temp) {
-                    max_temp = data_buffer[i].temperature;
-                }
+        if (scd41_async_receive(&sample, pdMS_TO_TICKS(SENSOR_TIMEOUT_MS))) {
+            // The sensor's mode is accounted from the first sample taken
+            // in it; the interval across a mode change is no jitter
+            if (sample.low_power != low_power) {
+                low_power = sample.low_power;
+                power_set_sensor_low_power(low_power);
+                last_read_us = 0;
             }
 
-            for (int i = 1; i < 12; i++) {
-                if (data_buffer[i].co2_ppm < min_co2) {
-                    min_co2 = data_buffer[i].co2_ppm;
-                }
-                if (data_buffer[i].co2_ppm > max_co2) {
-                    max_co2 = data_buffer[i].co2_ppm;
-                }
+            // Deviation of the sample interval from the nominal period
+            if (last_read_us != 0) {
+                const int64_t period_us =
+                    (int64_t)(low_power ? SCD41_ASYNC_LP_PERIOD_MS : SCD41_ASYNC_PERIOD_MS) * 1000;
+                const int64_t off = sample.read_us - last_read_us - period_us;
+                perf_hist_add(jitter_hist, (uint32_t)(off < 0 ? -off : off));
             }
+            last_read_us = sample.read_us;
 
-            for (int i = 1; i < 12; i++) {
-                if (data_buffer[i].humidity < min_hum) {
-                    min_hum = data_buffer[i].humidity;
-                }
-                if (data_buffer[i].humidity > max_hum) {
-                    max_hum = data_buffer[i].humidity;
+            const ts_point_t point = {
+                .temp_cdeg = sample.temp_cdeg,
+                .hum_cpct = sample.hum_cpct,
+                .co2_ppm = sample.co2_ppm,
+            };
+
+            const int32_t values[WEXT_CHANNELS] = {
+                [WEXT_CH_TEMP] = point.temp_cdeg,
+                [WEXT_CH_HUM] = point.hum_cpct,
+                [WEXT_CH_CO2] = point.co2_ppm,
+            };
+
+            const uint32_t now_s = sample_log_time_s();
+            window_extrema_push(&minmax_window, values);
+
+            // Wait-free publish; the UI reads it when it drains the queue
+            snap.count++;
+            snap.time_s = now_s;
+            snap.latest = point;
+            window_minmax(&snap.min, &snap.max);
+            sensor_snapshot_publish(&sensor_cell, &snap);
+
+            if (xSemaphoreTake(history_mutex, portMAX_DELAY) == pdTRUE) {
+                sample_store_add(&history, now_s, &point);
+                for (int i = 0; i < SPAN_COUNT; i++) {
+                    span_feed(&spans[i]);
                 }
+                xSemaphoreGive(history_mutex);
             }
+            sample_log_append(now_s, &point);
+            ui_queue_post(UI_CMD_SAMPLE, 0);
 
         } else {
-            ESP_LOGW(TAG, "Failed to read sensor data");
+            ESP_LOGW(TAG, "No sensor data for %d ms", SENSOR_TIMEOUT_MS);
+        }
+
+        power_account_buses();
+        if ((int32_t)(sample_log_time_s() - next_report_s) >= 0) {
+            power_log_report();
+            span_log_report();
+            next_report_s += POWER_REPORT_PERIOD_S;
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(5000));
     }
 }
 
 void app_main(void)
 {
     // esp_task_wdt_init(10, true);
-    data_mutex = xSemaphoreCreateMutex();
-    
-    init_lcd(LV_DISP_ROT_270);
-    
-    if (lvgl_port_lock(0)) {
-        create_sensor_screen();
-
-        esp_task_wdt_reset();
-        // Create temperature graph screen (0-40°C)
-        create_graph_screen(&screen_temp_graph, &label_max_temp_data, &label_min_temp_data,
-                          &temp_chart, &temp_series, 40);
-        
-        esp_task_wdt_reset();
-        // Create humidity graph screen (0-100%)
-        create_graph_screen(&screen_hum_graph, &label_max_hum_data, &label_min_hum_data,
-                          &hum_chart, &hum_series, 100);
-        
-        esp_task_wdt_reset();
-        // Create CO2 graph screen (0-2000 ppm)
-        create_graph_screen(&screen_co2_graph, &label_max_co2_data, &label_min_co2_data,
-                          &co2_chart, &co2_series, 2000);
-        esp_task_wdt_reset();
-        
-        lv_screen_load(screen_sensor);
-        
-        lvgl_port_unlock();
+    power_init();
+    history_mutex = xSemaphoreCreateMutex();
+    sensor_snapshot_init(&sensor_cell);
+    ESP_ERROR_CHECK(ui_queue_init(UI_QUEUE_DEPTH));
+    ESP_ERROR_CHECK(window_extrema_init(&minmax_window, MINMAX_WINDOW_SAMPLES));
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        ESP_ERROR_CHECK(window_extrema_init(&spans[i].window, spans[i].buckets));
     }
+    sample_store_init(&history);
+
+    esp_err_t err = sample_log_init();
+    if (err == ESP_OK) {
+        sample_log_restore(HISTORY_RESTORE_HOURS, restore_sample_cb, NULL);
+        ESP_ERROR_CHECK(sample_log_start());
+    } else {
+        ESP_LOGW(TAG, "Sample log unavailable (%s), history will not persist", esp_err_to_name(err));
+    }
+    
+    init_lcd(SCREEN_ROTATION);
+    power_set_backlight(true);
+    ui_queue_set_wake(lvgl_sched_wake, lvgl_sched_wake_from_isr);
     
-    // Create LVGL timer to update UI every 500ms
-    create_sensor_labels();
+    if (lvgl_sched_lock(0)) {
+#if GRAPH_STRIP_CHART
+        strip_chart_set_hw_scroll(graph_hw_scroll);
+#endif
+        ui_subjects_init();
+        diag_init();
+        ESP_ERROR_CHECK(screen_registry_init(lv_display_get_default(), screen_descs, SCREEN_COUNT,
+                                             SCREEN_BUILD_ALL ? 0 : SCREEN_HEAP_RESERVE));
+#if SCREEN_BUILD_ALL
+        for (int i = 0; i < SCREEN_COUNT; i++) {
+            screen_registry_build(i);
+            esp_task_wdt_reset();
+        }
+#endif
 
+        // Min/max of restored history is known before the first sample
+        if (window_extrema_count(&minmax_window) > 0) {
+            ts_point_t lo, hi;
+            window_minmax(&lo, &hi);
+            ui_publish_extrema(&lo, &hi);
+        }
+        lvgl_sched_set_pre_handler(ui_apply_queue);
+        lv_display_add_event_cb(lv_display_get_default(), ui_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+
+        load_current_screen();
+
+        lvgl_sched_unlock();
+    }
     
     // Start tasks
     xTaskCreate(scd_task, "scd_task", 4096, NULL, 5, NULL);
-    xTaskCreate(on_off_button_task, "on_off_button_task", 4096, NULL, 5, NULL);
-    xTaskCreate(next_screen_button_task, "next_screen_button_task", 4096, NULL, 5, NULL);
-    
-    // LVGL task handler loop
-    while (1) {
-        lv_timer_handler();
-        vTaskDelay(pdMS_TO_TICKS(20));
-    }
+
+    // Next: short press advances, long press goes back. On/off: short press
+    // toggles the screen, double press flips it.
+    static const input_button_cfg_t buttons[] = {
+        [BUTTON_ON_OFF] = { .gpio = ON_OFF_BUTTON, .double_press_ms = ON_OFF_DOUBLE_PRESS_MS },
+        [BUTTON_NEXT] = { .gpio = NEXT_SCREEN_BUTTON, .double_press_ms = 0 },
+    };
+    ESP_ERROR_CHECK(input_init(buttons, sizeof(buttons) / sizeof(buttons[0]), input_event_cb, NULL));
 }
@@ -0,0 +1,116 @@
+#include <stdbool.h>
+#include "ui_theme.h"
+
+LV_FONT_DECLARE(jet_mono_light_32)
+LV_FONT_DECLARE(noto_sans_jap)
+
+static lv_style_t style_screen;
+static lv_style_t style_value;
+static lv_style_t style_caption_jp;
+static lv_style_t style_text;
+static lv_style_t style_text_dim;
+static lv_style_t style_label_max;
+static lv_style_t style_label_min;
+static lv_style_t style_axis_ticks;
+static lv_style_t style_rule;
+static lv_style_t style_chart;
+static lv_style_t style_series;
+
+static const ui_theme_t theme = {
+    .screen = &style_screen,
+    .value = &style_value,
+    .caption_jp = &style_caption_jp,
+    .text = &style_text,
+    .text_dim = &style_text_dim,
+    .label_max = &style_label_max,
+    .label_min = &style_label_min,
+    .axis_ticks = &style_axis_ticks,
+    .rule = &style_rule,
+    .chart = &style_chart,
+    .series = &style_series,
+};
+
+static ui_theme_stats_t stats;
+
+static void text_style(lv_style_t *style, const lv_font_t *font, lv_color_t color)
+{
+    lv_style_init(style);
+    lv_style_set_text_font(style, font);
+    lv_style_set_text_color(style, color);
+}
+
+const ui_theme_t *ui_theme_get(void)
+{
+    static bool ready = false;
+
+    if (ready) {
+        return &theme;
+    }
+    ready = true;
+
+    lv_style_init(&style_screen);
+    lv_style_set_bg_color(&style_screen, UI_COLOR_BG);
+    lv_style_set_bg_opa(&style_screen, LV_OPA_COVER);
+
+    text_style(&style_value, &jet_mono_light_32, UI_COLOR_TEXT);
+    text_style(&style_caption_jp, &noto_sans_jap, UI_COLOR_TEXT);
+    text_style(&style_text, &lv_font_montserrat_14, UI_COLOR_TEXT);
+    text_style(&style_text_dim, &lv_font_montserrat_10, UI_COLOR_TEXT_DIM);
+    text_style(&style_label_max, &lv_font_montserrat_14, UI_COLOR_MAX);
+    text_style(&style_label_min, &lv_font_montserrat_14, UI_COLOR_MIN);
+
+    lv_style_init(&style_axis_ticks);
+    lv_style_set_line_color(&style_axis_ticks, UI_COLOR_TICK);
+    lv_style_set_length(&style_axis_ticks, 5);
+
+    lv_style_init(&style_rule);
+    lv_style_set_line_width(&style_rule, 2);
+    lv_style_set_line_color(&style_rule, UI_COLOR_TEXT);
+
+    lv_style_init(&style_chart);
+    lv_style_set_bg_color(&style_chart, UI_COLOR_BG);
+    lv_style_set_border_width(&style_chart, 1);
+    lv_style_set_border_color(&style_chart, UI_COLOR_CHART_BORDER);
+    lv_style_set_pad_all(&style_chart, 5);
+    lv_style_set_line_color(&style_chart, UI_COLOR_GRID);
+    lv_style_set_line_width(&style_chart, 1);
+
+    lv_style_init(&style_series);
+    lv_style_set_line_width(&style_series, 3);
+    lv_style_set_bg_opa(&style_series, LV_OPA_50);
+    lv_style_set_bg_color(&style_series, UI_COLOR_SERIES);
+
+    return &theme;
+}
+
+static uint32_t heap_used(void)
+{
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+void ui_theme_apply(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t selector)
+{
+    const uint32_t before = heap_used();
+
+#if UI_THEME_LOCAL_STYLES
+    for (lv_style_prop_t prop = 1; prop < LV_STYLE_LAST_BUILT_IN_PROP; prop++) {
+        lv_style_value_t value;
+        if (lv_style_get_prop(style, prop, &value) == LV_STYLE_RES_FOUND) {
+            lv_obj_set_local_style_prop(obj, prop, value, selector);
+        }
+    }
+#else
+    lv_obj_add_style(obj, style, selector);
+#endif
+
+    stats.objects++;
+    stats.heap_bytes += heap_used() - before;
+}
+
+void ui_theme_get_stats(ui_theme_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+// Colours and shared styles of every screen.
+//
+// lv_color_make() takes 8-bit channels; these are the values the screens
+// have always used on this panel. Keep every colour here.
+#define UI_COLOR_BG             lv_color_make(0, 0, 0)
+#define UI_COLOR_TEXT           lv_color_make(31, 31, 63)   // titles, values
+#define UI_COLOR_TEXT_DIM       lv_color_make(20, 20, 40)   // axis labels, diagnostics
+#define UI_COLOR_TICK           lv_color_make(15, 15, 30)
+#define UI_COLOR_CHART_BORDER   lv_color_make(15, 15, 31)
+#define UI_COLOR_GRID           lv_color_make(10, 10, 20)
+#define UI_COLOR_SERIES         lv_color_make(31, 20, 50)
+#define UI_COLOR_MAX            lv_color_make(0, 31, 0)
+#define UI_COLOR_MIN            lv_color_make(31, 0, 0)
+
+// 1: ui_theme_apply() copies a style's properties into each object's local
+// style, as the widgets were styled before (scd41_lcd_sim_localstyles)
+#ifndef UI_THEME_LOCAL_STYLES
+#define UI_THEME_LOCAL_STYLES 0
+#endif
+
+typedef struct {
+    const lv_style_t *screen;       // black background
+    const lv_style_t *value;        // large readings and sensor captions
+    const lv_style_t *caption_jp;   // Japanese sensor captions
+    const lv_style_t *text;         // small white text: graph min/max values, titles
+    const lv_style_t *text_dim;     // small grey text: axis labels, diagnostics
+    const lv_style_t *label_max;    // "Max:" caption
+    const lv_style_t *label_min;    // "Min:" caption
+    const lv_style_t *axis_ticks;   // scale LV_PART_INDICATOR
+    const lv_style_t *rule;         // line under the graph
+    const lv_style_t *chart;        // chart background, border and grid
+    const lv_style_t *series;       // chart LV_PART_ITEMS
+} ui_theme_t;
+
+typedef struct {
+    uint32_t objects;               // ui_theme_apply() calls
+    uint32_t heap_bytes;            // LVGL heap those calls took
+} ui_theme_stats_t;
+
+// Initialises the styles once; later calls return the same theme.
+// Call with the LVGL lock held.
+const ui_theme_t *ui_theme_get(void);
+
+// lv_obj_add_style(), or a local copy with UI_THEME_LOCAL_STYLES
+void ui_theme_apply(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t selector);
+
+void ui_theme_get_stats(ui_theme_stats_t *stats);
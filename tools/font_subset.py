@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Generate subset LVGL fonts from the strings the UI actually uses.
+
+Scans C sources for string literals, keeps the characters a font can be
+asked to draw, and runs lv_font_conv on just those glyphs:
+
+    font_subset.py --name jet_mono_light_32 --font JetBrainsMono-Light.ttf \\
+        --size 32 --bpp 2 --compress --filter ascii --symbols "0123456789.-" \\
+        --scan main/scd41_lcd.c main/diag.c --out build/jet_mono_light_32.c
+
+Literals inside ESP_LOGx() calls, #include lines and TAG definitions are
+never drawn and are skipped; printf conversions are removed, so numbers
+formatted at runtime need their glyphs passed with --symbols.
+
+Every run (and --report FILE.c on an existing font) prints a size and
+render-cost summary: glyph count, bitmap bytes in flash, and the largest
+glyph, which bounds the A8 buffer LVGL decodes compressed or sub-8 bpp
+glyphs into.
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+
+LOG_CALL = re.compile(r'\bESP_LOG[EWIDV]\s*\(|\bESP_DRAM_LOG[EWIDV]\s*\(')
+STRING = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+PRINTF_CONV = re.compile(r'%[-+ #0]*(?:\d+|\*)?(?:\.(?:\d+|\*))?(?:hh|h|ll|l|L|z|j|t)?[diouxXeEfgGcsp%]')
+GLYPH_DSC = re.compile(r'\.bitmap_index\s*=\s*(\d+).*?\.box_w\s*=\s*(\d+),\s*\.box_h\s*=\s*(\d+)')
+
+
+def strip_comments(src):
+    src = re.sub(r'/\*.*?\*/', ' ', src, flags=re.S)
+    return re.sub(r'//[^\n]*', ' ', src)
+
+
+def skip_call(src, start):
+    """Index just past the parenthesised argument list opening before start."""
+    depth = 1
+    i = start
+    while i < len(src) and depth:
+        c = src[i]
+        if c == '"':
+            m = STRING.match(src, i)
+            i = m.end() if m else i + 1
+            continue
+        if c == '(':
+            depth += 1
+        elif c == ')':
+            depth -= 1
+        i += 1
+    return i
+
+
+def drawn_literals(path):
+    with open(path, encoding='utf-8') as f:
+        src = strip_comments(f.read())
+    src = re.sub(r'^\s*#\s*include[^\n]*', ' ', src, flags=re.M)
+    src = re.sub(r'\bTAG\s*=\s*"[^"]*"', ' ', src)
+
+    kept = []
+    pos = 0
+    for m in LOG_CALL.finditer(src):
+        if m.start() < pos:
+            continue
+        kept.append(src[pos:m.start()])
+        pos = skip_call(src, m.end())
+    kept.append(src[pos:])
+
+    for m in STRING.finditer(''.join(kept)):
+        text = bytes(m.group(1), 'utf-8').decode('unicode_escape').encode('latin-1').decode('utf-8')
+        yield PRINTF_CONV.sub('', text)
+
+
+def glyph_set(sources, filt, symbols):
+    chars = set(symbols)
+    for path in sources:
+        for text in drawn_literals(path):
+            chars.update(c for c in text if c.isprintable())
+    if filt == 'ascii':
+        chars = {c for c in chars if ' ' <= c <= '~'}
+    elif filt == 'non-ascii':
+        chars = {c for c in chars if ord(c) > 0x7e}
+    return ''.join(sorted(chars))
+
+
+def report(path):
+    with open(path, encoding='utf-8') as f:
+        src = f.read()
+    bitmap = re.search(r'glyph_bitmap\[\]\s*=\s*\{(.*?)\};', src, re.S)
+    bitmap_bytes = len(re.findall(r'0x[0-9a-fA-F]+', strip_comments(bitmap.group(1)))) if bitmap else 0
+    glyphs = [(int(w), int(h)) for _, w, h in GLYPH_DSC.findall(src)][1:]    # id 0 is reserved
+    bpp = re.search(r'\.bpp\s*=\s*(\d+)', src)
+    fmt = re.search(r'\.bitmap_format\s*=\s*(\d+)', src)
+    largest = max((w * h for w, h in glyphs), default=0)
+    compressed = bool(fmt and int(fmt.group(1)))
+
+    print(f'{path}: glyphs={len(glyphs)} bpp={bpp.group(1) if bpp else "?"} '
+          f'compressed={"yes" if compressed else "no"} bitmap_bytes={bitmap_bytes} '
+          f'bytes_per_glyph={bitmap_bytes / len(glyphs) if glyphs else 0:.1f} '
+          f'largest_glyph_a8_bytes={largest}')
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--name', help='C symbol of the font')
+    ap.add_argument('--font', help='TTF/OTF source')
+    ap.add_argument('--size', type=int, default=32)
+    ap.add_argument('--bpp', type=int, choices=(1, 2, 3, 4, 8), default=1)
+    ap.add_argument('--compress', action='store_true', help='RLE-compress glyph bitmaps')
+    ap.add_argument('--filter', choices=('all', 'ascii', 'non-ascii'), default='all')
+    ap.add_argument('--symbols', default='', help='glyphs always included')
+    ap.add_argument('--scan', nargs='*', default=[], help='C sources to take strings from')
+    ap.add_argument('--out', help='generated C file')
+    ap.add_argument('--lv-font-conv', default='lv_font_conv')
+    ap.add_argument('--report', nargs='*', metavar='FILE', help='only report on existing font files')
+    args = ap.parse_args()
+
+    if args.report is not None:
+        for path in args.report:
+            report(path)
+        return 0
+
+    if not (args.name and args.font and args.out):
+        ap.error('--name, --font and --out are required')
+    conv = shutil.which(args.lv_font_conv)
+    if not conv:
+        sys.exit(f'{args.lv_font_conv} not found (npm i -g lv_font_conv)')
+
+    glyphs = glyph_set(args.scan, args.filter, args.symbols)
+    if not glyphs:
+        sys.exit(f'{args.name}: no glyphs to generate')
+    print(f'{args.name}: {len(glyphs)} glyphs: {glyphs}')
+
+    cmd = [conv, '--bpp', str(args.bpp), '--size', str(args.size), '--stride', '1', '--align', '1',
+           '--font', args.font, '--symbols', glyphs, '--format', 'lvgl', '--lv-font-name', args.name,
+           '-o', args.out]
+    if not args.compress:
+        cmd.insert(5, '--no-compress')
+    subprocess.run(cmd, check=True)
+    report(args.out)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())